@@ -33,7 +33,15 @@
 #define __LIBV_ARENA_H__
 
 #include "libv/vmap/vmap.h"
+#include "libv/vmem/vmem.h"
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stddef.h>
+#include <string.h>
+
+#ifdef LIBV_ARENA_PROFILE
+#include <stdio.h>
+#endif // LIBV_ARENA_PROFILE
 
 LIBV_BEGIN
 
@@ -46,6 +54,10 @@ struct arena_block {
     unsigned char data[];
 };
 
+// alloc_wasted only counts space that cannot be handed out until the next
+// reset or rewind: alignment padding, the unused end of blocks the arena has
+// moved past and allocations left behind by realloc. the rest of alloc_size
+// is still free.
 typedef struct {
     size_t num_blocks;   // number of blocks
     size_t alloc_size;   // total amount allocated
@@ -53,16 +65,203 @@ typedef struct {
     size_t alloc_wasted; // size lost to alignment and fragmentation
 } arena_stats;
 
+// defining LIBV_ARENA_PROFILE before including arena.h makes every arena
+// record its peak usage, a histogram of allocation sizes, alignment padding
+// and, for arena_alloc_type and arena_alloc_array, the bytes allocated from
+// each call site. it must be defined the same way in every translation unit.
+#ifdef LIBV_ARENA_PROFILE
+
+#ifndef LIBV_ARENA_PROFILE_SITES
+#define LIBV_ARENA_PROFILE_SITES 256
+#endif // LIBV_ARENA_PROFILE_SITES
+
+#define LIBV_ARENA_PROFILE_BUCKETS 64
+
+typedef struct {
+    const char* file; // NULL for an unused entry
+    int line;
+    size_t count;
+    size_t bytes;
+} arena_profile_site;
+
+typedef struct {
+    size_t peak_used; // highest alloc_used seen, kept across resets
+    size_t padding;   // bytes lost to alignment padding
+    size_t histogram[LIBV_ARENA_PROFILE_BUCKETS]; // by floor(log2(size))
+    size_t dropped_sites; // allocations whose call site did not fit
+    arena_profile_site sites[LIBV_ARENA_PROFILE_SITES];
+} arena_profile;
+
+#endif // LIBV_ARENA_PROFILE
+
 typedef struct {
     arena_block* head;
-    arena_block* tail;
+    arena_block* tail; // the block currently being bump allocated from
+    arena_block* side; // dedicated blocks of oversized allocations
+    size_t num_side;   // length of the side list
     arena_stats stats;
+    size_t block_size; // size of the next block, 0 until the first block
+    size_t reserved;   // address space of an arena_new_vm arena, else 0
+#ifdef LIBV_ARENA_PROFILE
+    arena_profile* profile; // allocated on the first allocation
+#endif // LIBV_ARENA_PROFILE
 } arena;
 
+// the size of the first block. every new block doubles in size up to
+// LIBV_ARENA_MAX_BLOCK_SIZE. allocations of at least
+// LIBV_ARENA_SIDE_BLOCK_SIZE that do not fit in the tail get a dedicated
+// block instead, which arena_reset and arena_rewind free.
 #ifndef LIBV_ARENA_BLOCK_SIZE
 #define LIBV_ARENA_BLOCK_SIZE 4096
 #endif // LIBV_ARENA_BLOCK_SIZE
 
+#ifndef LIBV_ARENA_MAX_BLOCK_SIZE
+#define LIBV_ARENA_MAX_BLOCK_SIZE (1024 * 1024)
+#endif // LIBV_ARENA_MAX_BLOCK_SIZE
+
+#ifndef LIBV_ARENA_SIDE_BLOCK_SIZE
+#define LIBV_ARENA_SIDE_BLOCK_SIZE (LIBV_ARENA_MAX_BLOCK_SIZE / 4)
+#endif // LIBV_ARENA_SIDE_BLOCK_SIZE
+
+// the address space reserved when arena_new_vm is passed 0. reserving costs
+// nothing until pages are committed.
+#ifndef LIBV_ARENA_VM_RESERVE
+#if UINTPTR_MAX > 0xFFFFFFFF
+#define LIBV_ARENA_VM_RESERVE ((size_t)64 * 1024 * 1024 * 1024)
+#else
+#define LIBV_ARENA_VM_RESERVE ((size_t)256 * 1024 * 1024)
+#endif
+#endif // LIBV_ARENA_VM_RESERVE
+
+// pages of an arena_new_vm arena are committed this many bytes at a time
+#ifndef LIBV_ARENA_VM_COMMIT_SIZE
+#define LIBV_ARENA_VM_COMMIT_SIZE (64 * 1024)
+#endif // LIBV_ARENA_VM_COMMIT_SIZE
+
+// arena_reset gives everything an arena_new_vm arena committed above this
+// back to the os
+#ifndef LIBV_ARENA_VM_RETAIN
+#define LIBV_ARENA_VM_RETAIN (1024 * 1024)
+#endif // LIBV_ARENA_VM_RETAIN
+
+#ifdef LIBV_ARENA_PROFILE
+
+static inline arena_profile* arena_profile_get(arena* self) {
+    if (self->profile == NULL) {
+        self->profile = calloc(1, sizeof *self->profile);
+    }
+    return self->profile;
+}
+
+static inline void arena_profile_peak(arena* self) {
+    arena_profile* profile = arena_profile_get(self);
+    if (profile && self->stats.alloc_used > profile->peak_used) {
+        profile->peak_used = self->stats.alloc_used;
+    }
+}
+
+static inline void arena_profile_record(arena* self, size_t size,
+                                        size_t padding) {
+    arena_profile* profile = arena_profile_get(self);
+    if (profile == NULL) {
+        return;
+    }
+    size_t bucket = 0;
+    for (size_t n = size; n > 1; n >>= 1) {
+        ++bucket;
+    }
+    ++profile->histogram[bucket];
+    profile->padding += padding;
+    arena_profile_peak(self);
+}
+
+static inline void arena_profile_record_site(arena* self, const char* file,
+                                             int line, size_t size) {
+    arena_profile* profile = arena_profile_get(self);
+    if (profile == NULL) {
+        return;
+    }
+    size_t hash = ((uintptr_t)file >> 3) * 31 + (size_t)line;
+    for (size_t i = 0; i < LIBV_ARENA_PROFILE_SITES; ++i) {
+        arena_profile_site* site =
+            &profile->sites[(hash + i) % LIBV_ARENA_PROFILE_SITES];
+        if (site->file == NULL) {
+            site->file = file;
+            site->line = line;
+        } else if (site->line != line ||
+                   (site->file != file && strcmp(site->file, file) != 0)) {
+            continue;
+        }
+        ++site->count;
+        site->bytes += size;
+        return;
+    }
+    ++profile->dropped_sites;
+}
+
+static inline void arena_profile_json_string(FILE* out, const char* s) {
+    fputc('"', out);
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') {
+            fputc('\\', out);
+        }
+        fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+// writes the arena's stats and profile to out as a json object
+static inline int arena_profile_dump_json(const arena* self, FILE* out) {
+    const arena_profile* profile = self->profile;
+    fprintf(out,
+            "{\"num_blocks\":%zu,\"alloc_size\":%zu,\"alloc_used\":%zu,"
+            "\"alloc_wasted\":%zu",
+            self->stats.num_blocks, self->stats.alloc_size,
+            self->stats.alloc_used, self->stats.alloc_wasted);
+    if (profile == NULL) {
+        fprintf(out, "}\n");
+        return ferror(out) ? LIBV_ERR : LIBV_OK;
+    }
+    fprintf(out, ",\"peak_used\":%zu,\"padding\":%zu,\"histogram\":[",
+            profile->peak_used, profile->padding);
+    bool first = true;
+    for (size_t i = 0; i < LIBV_ARENA_PROFILE_BUCKETS; ++i) {
+        if (profile->histogram[i] == 0) {
+            continue;
+        }
+        size_t min = (size_t)1 << i;
+        fprintf(out, "%s{\"min\":%zu,\"max\":%zu,\"count\":%zu}",
+                first ? "" : ",", min, min + (min - 1), profile->histogram[i]);
+        first = false;
+    }
+    fprintf(out, "],\"sites\":[");
+    first = true;
+    for (size_t i = 0; i < LIBV_ARENA_PROFILE_SITES; ++i) {
+        const arena_profile_site* site = &profile->sites[i];
+        if (site->file == NULL) {
+            continue;
+        }
+        fprintf(out, "%s{\"file\":", first ? "" : ",");
+        arena_profile_json_string(out, site->file);
+        fprintf(out, ",\"line\":%d,\"count\":%zu,\"bytes\":%zu}",
+                site->line, site->count, site->bytes);
+        first = false;
+    }
+    fprintf(out, "],\"dropped_sites\":%zu}\n", profile->dropped_sites);
+    return ferror(out) ? LIBV_ERR : LIBV_OK;
+}
+
+#define LIBV_ARENA_PROFILE_RECORD(self_, size_, padding_)                      \
+    arena_profile_record(self_, size_, padding_)
+#define LIBV_ARENA_PROFILE_PEAK(self_) arena_profile_peak(self_)
+
+#else
+
+#define LIBV_ARENA_PROFILE_RECORD(self_, size_, padding_) ((void)0)
+#define LIBV_ARENA_PROFILE_PEAK(self_) ((void)0)
+
+#endif // LIBV_ARENA_PROFILE
+
 static inline bool is_power_of_two(size_t x) {
     return x != 0 && (x & (x - 1)) == 0;
 }
@@ -71,13 +270,199 @@ static inline uintptr_t align_up(uintptr_t p, size_t align) {
     return (p + align - 1) & ~(uintptr_t)(align - 1);
 }
 
+// free blocks are recycled instead of going back to malloc. each thread
+// caches up to LIBV_ARENA_POOL_THREAD_BLOCKS blocks of every size, the rest
+// go to a shared pool that holds up to LIBV_ARENA_POOL_MAX_BYTES. only blocks
+// of the geometric sizes between LIBV_ARENA_BLOCK_SIZE and
+// LIBV_ARENA_MAX_BLOCK_SIZE are recycled, set both limits to 0 to always use
+// malloc.
+//
+// the pool and the thread caches are shared by the whole process. exactly
+// one translation unit must define LIBV_ARENA_IMPLEMENTATION before including
+// arena.h, that is where they are defined, every other translation unit only
+// declares them. a thread's cache is handed to the shared pool when the
+// thread exits, arena_pool_release does the same earlier.
+#ifndef LIBV_ARENA_POOL_THREAD_BLOCKS
+#define LIBV_ARENA_POOL_THREAD_BLOCKS 4
+#endif // LIBV_ARENA_POOL_THREAD_BLOCKS
+
+#ifndef LIBV_ARENA_POOL_MAX_BYTES
+#define LIBV_ARENA_POOL_MAX_BYTES (64 * 1024 * 1024)
+#endif // LIBV_ARENA_POOL_MAX_BYTES
+
+#define LIBV_ARENA_POOL_CLASSES 32
+
+typedef struct {
+    arena_block* blocks[LIBV_ARENA_POOL_CLASSES];
+    size_t counts[LIBV_ARENA_POOL_CLASSES];
+    bool registered; // the thread exit destructor is armed
+} arena_block_cache;
+
+typedef struct {
+    atomic_flag lock;
+    arena_block* blocks[LIBV_ARENA_POOL_CLASSES];
+    size_t bytes;
+    pthread_once_t once;
+    pthread_key_t key; // flushes a thread's cache when the thread exits
+    bool has_key;      // false if the key could not be created
+} arena_block_pool;
+
+#ifdef LIBV_ARENA_IMPLEMENTATION
+_Thread_local arena_block_cache arena_block_thread_cache;
+arena_block_pool arena_block_shared_pool = {
+    .lock = ATOMIC_FLAG_INIT,
+    .once = PTHREAD_ONCE_INIT,
+};
+#else
+extern _Thread_local arena_block_cache arena_block_thread_cache;
+extern arena_block_pool arena_block_shared_pool;
+#endif // LIBV_ARENA_IMPLEMENTATION
+
+// the pool list a block of size bytes belongs in, -1 if it is not recycled
+static inline int arena_block_class(size_t size) {
+    if (size < LIBV_ARENA_BLOCK_SIZE || size > LIBV_ARENA_MAX_BLOCK_SIZE ||
+        size % LIBV_ARENA_BLOCK_SIZE != 0 ||
+        !is_power_of_two(size / LIBV_ARENA_BLOCK_SIZE)) {
+        return -1;
+    }
+    int cls = 0;
+    for (size_t n = size / LIBV_ARENA_BLOCK_SIZE; n > 1; n >>= 1) {
+        ++cls;
+    }
+    return cls < LIBV_ARENA_POOL_CLASSES ? cls : -1;
+}
+
+static inline void arena_block_pool_lock(void) {
+    while (atomic_flag_test_and_set_explicit(&arena_block_shared_pool.lock,
+                                             memory_order_acquire)) {
+    }
+}
+
+static inline void arena_block_pool_unlock(void) {
+    atomic_flag_clear_explicit(&arena_block_shared_pool.lock,
+                               memory_order_release);
+}
+
+static inline arena_block* arena_block_pool_get(size_t size) {
+    int cls = arena_block_class(size);
+    if (cls < 0) {
+        return NULL;
+    }
+    arena_block_cache* cache = &arena_block_thread_cache;
+    arena_block* block = cache->blocks[cls];
+    if (block) {
+        cache->blocks[cls] = block->next;
+        --cache->counts[cls];
+        return block;
+    }
+    arena_block_pool_lock();
+    block = arena_block_shared_pool.blocks[cls];
+    if (block) {
+        arena_block_shared_pool.blocks[cls] = block->next;
+        arena_block_shared_pool.bytes -= block->size;
+    }
+    arena_block_pool_unlock();
+    return block;
+}
+
+// hands a block to the shared pool, or back to malloc once the pool is full
+static inline void arena_block_pool_put_shared(arena_block* block, int cls) {
+    arena_block_pool_lock();
+    if (arena_block_shared_pool.bytes + block->size <=
+        LIBV_ARENA_POOL_MAX_BYTES) {
+        block->next = arena_block_shared_pool.blocks[cls];
+        arena_block_shared_pool.blocks[cls] = block;
+        arena_block_shared_pool.bytes += block->size;
+        block = NULL;
+    }
+    arena_block_pool_unlock();
+    free(block);
+}
+
+static inline void arena_block_cache_flush(arena_block_cache* cache) {
+    for (int cls = 0; cls < LIBV_ARENA_POOL_CLASSES; ++cls) {
+        while (cache->blocks[cls]) {
+            arena_block* block = cache->blocks[cls];
+            cache->blocks[cls] = block->next;
+            arena_block_pool_put_shared(block, cls);
+        }
+        cache->counts[cls] = 0;
+    }
+}
+
+// blocks cached by later destructors arm it again, pthreads runs them again
+static inline void arena_block_cache_exit(void* cache) {
+    ((arena_block_cache*)cache)->registered = false;
+    arena_block_cache_flush(cache);
+}
+
+static inline void arena_block_pool_create_key(void) {
+    arena_block_shared_pool.has_key =
+        pthread_key_create(&arena_block_shared_pool.key,
+                           arena_block_cache_exit) == 0;
+}
+
+// arms the destructor that flushes the cache when the thread exits. without
+// one the thread does not cache at all rather than leak its blocks.
+static inline bool arena_block_cache_register(arena_block_cache* cache) {
+    pthread_once(&arena_block_shared_pool.once, arena_block_pool_create_key);
+    cache->registered = arena_block_shared_pool.has_key &&
+                        pthread_setspecific(arena_block_shared_pool.key,
+                                            cache) == 0;
+    return cache->registered;
+}
+
+static inline void arena_block_pool_put(arena_block* block) {
+    int cls = arena_block_class(block->size);
+    if (cls < 0) {
+        free(block);
+        return;
+    }
+    arena_block_cache* cache = &arena_block_thread_cache;
+    if (cache->counts[cls] < LIBV_ARENA_POOL_THREAD_BLOCKS &&
+        (cache->registered || arena_block_cache_register(cache))) {
+        block->next = cache->blocks[cls];
+        cache->blocks[cls] = block;
+        ++cache->counts[cls];
+        return;
+    }
+    arena_block_pool_put_shared(block, cls);
+}
+
+// moves the calling thread's cached blocks to the shared pool now instead of
+// when the thread exits
+static inline void arena_pool_release(void) {
+    arena_block_cache_flush(&arena_block_thread_cache);
+}
+
+// frees every block in the shared pool, blocks still in thread caches are not
+// touched
+static inline void arena_pool_trim(void) {
+    arena_block* blocks[LIBV_ARENA_POOL_CLASSES];
+    arena_block_pool_lock();
+    memcpy(blocks, arena_block_shared_pool.blocks, sizeof blocks);
+    memset(arena_block_shared_pool.blocks, 0,
+           sizeof arena_block_shared_pool.blocks);
+    arena_block_shared_pool.bytes = 0;
+    arena_block_pool_unlock();
+    for (int cls = 0; cls < LIBV_ARENA_POOL_CLASSES; ++cls) {
+        while (blocks[cls]) {
+            arena_block* next = blocks[cls]->next;
+            free(blocks[cls]);
+            blocks[cls] = next;
+        }
+    }
+}
+
 static inline arena_block* arena_block_new(arena* arena, size_t size) {
-    arena_block* self = malloc(sizeof *self + size);
+    arena_block* self = arena_block_pool_get(size);
+    if (!self) {
+        self = malloc(sizeof *self + size);
+    }
     if (!self) {
         return NULL;
     }
     arena->stats.alloc_size += size;
-    arena->stats.alloc_wasted += size;
     ++arena->stats.num_blocks;
     self->size = size;
     self->next = NULL;
@@ -85,11 +470,149 @@ static inline arena_block* arena_block_new(arena* arena, size_t size) {
     return self;
 }
 
-static inline void arena_block_destroy(arena_block* self) { free(self); }
+static inline void arena_block_destroy(arena_block* self) {
+    arena_block_pool_put(self);
+}
 
 static inline arena arena_new(void) { return (arena){0}; }
 
+// an arena backed by one reserved range of address space instead of a chain
+// of blocks. the range is mapped PROT_NONE on the first allocation and pages
+// are committed as the bump pointer reaches them, so allocations are
+// contiguous and the last one can always grow in place until the reservation
+// runs out. the range starts with the arena's only block, which grows as
+// pages are committed, so every other arena function works on it unchanged.
+// reserve is rounded up to a page, 0 reserves LIBV_ARENA_VM_RESERVE. without
+// mmap this is arena_new.
+static inline arena arena_new_vm(size_t reserve) {
+#if LIBV_VMEM_HAVE_MMAP
+    return (arena){.reserved = reserve ? reserve : LIBV_ARENA_VM_RESERVE};
+#else
+    LIBV_UNUSED(reserve);
+    return arena_new();
+#endif // LIBV_VMEM_HAVE_MMAP
+}
+
+static inline size_t arena_vm_granule(void) {
+    return vmem_round_up(LIBV_ARENA_VM_COMMIT_SIZE, vmem_page_size());
+}
+
+// maps the reservation and commits its first granule as the head block
+static inline int arena_vm_reserve(arena* self) {
+#if LIBV_VMEM_HAVE_MMAP
+    size_t header = offsetof(arena_block, data);
+    self->reserved = vmem_round_up(self->reserved, vmem_page_size());
+    void* base = mmap(NULL, self->reserved, PROT_NONE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        return LIBV_ERR;
+    }
+    size_t commit = arena_vm_granule();
+    if (commit > self->reserved) {
+        commit = self->reserved;
+    }
+    if (mprotect(base, commit, PROT_READ | PROT_WRITE) != 0) {
+        munmap(base, self->reserved);
+        return LIBV_ERR;
+    }
+    arena_block* block = base;
+    block->next = NULL;
+    block->used = 0;
+    block->size = commit - header;
+    self->head = self->tail = block;
+    self->stats.num_blocks = 1;
+    self->stats.alloc_size = block->size;
+    return LIBV_OK;
+#else
+    LIBV_UNUSED(self);
+    return LIBV_ERR;
+#endif // LIBV_VMEM_HAVE_MMAP
+}
+
+// grows the head block to at least size bytes by committing more pages
+LIBV_INLINE_NEVER static int arena_vm_commit(arena* self, size_t size) {
+    arena_block* block = self->head;
+    if (size <= block->size) {
+        return LIBV_OK;
+    }
+    size_t header = offsetof(arena_block, data);
+    if (size > self->reserved - header) {
+        return LIBV_ERR;
+    }
+#if LIBV_VMEM_HAVE_MMAP
+    size_t committed = header + block->size;
+    size_t commit = vmem_round_up(header + size, arena_vm_granule());
+    if (commit > self->reserved) {
+        commit = self->reserved;
+    }
+    if (mprotect((unsigned char*)block + committed, commit - committed,
+                 PROT_READ | PROT_WRITE) != 0) {
+        return LIBV_ERR;
+    }
+    self->stats.alloc_size += commit - committed;
+    block->size = commit - header;
+    return LIBV_OK;
+#else
+    return LIBV_ERR;
+#endif // LIBV_VMEM_HAVE_MMAP
+}
+
+// gives the pages committed past the first retain bytes back to the os. the
+// first page holds the block header and always stays.
+static inline void arena_vm_trim(arena* self, size_t retain) {
+#if LIBV_VMEM_HAVE_MMAP
+    arena_block* block = self->head;
+    if (block == NULL) {
+        return;
+    }
+    size_t header = offsetof(arena_block, data);
+    size_t committed = header + block->size;
+    size_t keep = vmem_round_up(retain, vmem_page_size());
+    if (keep < vmem_page_size()) {
+        keep = vmem_page_size();
+    }
+    if (committed > keep) {
+        unsigned char* base = (unsigned char*)block;
+        madvise(base + keep, committed - keep, MADV_DONTNEED);
+        mprotect(base + keep, committed - keep, PROT_NONE);
+        self->stats.alloc_size -= committed - keep;
+        block->size = keep - header;
+    }
+#else
+    LIBV_UNUSED(self);
+    LIBV_UNUSED(retain);
+#endif // LIBV_VMEM_HAVE_MMAP
+}
+
+// unmaps the reservation, the arena can be used again afterwards
+static inline void arena_vm_unmap(arena* self) {
+#if LIBV_VMEM_HAVE_MMAP
+    if (self->head) {
+        munmap(self->head, self->reserved);
+    }
+#endif // LIBV_VMEM_HAVE_MMAP
+    self->head = self->tail = NULL;
+    self->stats = (arena_stats){0};
+}
+
+// frees the newest side blocks until only keep are left
+static inline void arena_release_side(arena* self, size_t keep) {
+    while (self->num_side > keep) {
+        arena_block* next = self->side->next;
+        self->stats.alloc_size -= self->side->size;
+        --self->stats.num_blocks;
+        arena_block_destroy(self->side);
+        self->side = next;
+        --self->num_side;
+    }
+}
+
 static inline void arena_destroy(arena* self) {
+    if (self->reserved) {
+        arena_vm_unmap(self);
+    }
+    arena_release_side(self, 0);
+
     arena_block* current = self->head;
     while (true) {
         if (!current) {
@@ -105,25 +628,20 @@ static inline void arena_destroy(arena* self) {
 
     self->head = self->tail = NULL;
     self->stats.num_blocks = 0;
+#ifdef LIBV_ARENA_PROFILE
+    free(self->profile);
+    self->profile = NULL;
+#endif // LIBV_ARENA_PROFILE
 }
 
-static inline int arena_maybe_initialize(arena* self, size_t size) {
-    if (self->tail != NULL) {
-        return LIBV_OK;
-    }
-    libv_assert(self->head == NULL,
-                "arena in invalid state, tail == NULL but head != NULL");
-
-    size = size > LIBV_ARENA_BLOCK_SIZE ? size : LIBV_ARENA_BLOCK_SIZE;
-
-    arena_block* block = arena_block_new(self, size);
-    if (block == NULL) {
-        return LIBV_ERR;
-    }
-
-    self->head = self->tail = block;
-
-    return LIBV_OK;
+// returns the size for a new block that must hold at least min_size bytes
+// and advances the geometric growth.
+static inline size_t arena_next_block_size(arena* self, size_t min_size) {
+    size_t size = self->block_size ? self->block_size : LIBV_ARENA_BLOCK_SIZE;
+    self->block_size = size < LIBV_ARENA_MAX_BLOCK_SIZE / 2
+                           ? size * 2
+                           : LIBV_ARENA_MAX_BLOCK_SIZE;
+    return size > min_size ? size : min_size;
 }
 
 typedef struct {
@@ -132,128 +650,463 @@ typedef struct {
     size_t size_needed;
 } arena_valid_block;
 
+static inline arena_valid_block arena_block_fit(arena_block* block,
+                                                size_t size, size_t align) {
+    uintptr_t ptr = (uintptr_t)(block->data + block->used);
+    uintptr_t aligned = align_up(ptr, align);
+    size_t size_needed = aligned - ptr + size;
+    if (size_needed > block->size - block->used) {
+        return (arena_valid_block){0};
+    }
+    return (arena_valid_block){block, aligned, size_needed};
+}
+
+// an oversized allocation gets a block of its own on the side list, so it
+// neither strands the rest of the tail nor leaves its own leftovers to later
+// small allocations.
+static inline arena_valid_block arena_side_block(arena* self, size_t size,
+                                                 size_t align) {
+    arena_block* block = arena_block_new(self, size + align);
+    if (block == NULL) {
+        return (arena_valid_block){0};
+    }
+    block->next = self->side;
+    self->side = block;
+    ++self->num_side;
+    arena_valid_block res = arena_block_fit(block, size, align);
+    // the block holds nothing else, so whatever this leaves over is lost
+    self->stats.alloc_wasted += block->size - res.size_needed;
+    return res;
+}
+
+// finds a block for an allocation that did not fit in the tail. only the
+// block after the tail is considered, otherwise a new block is linked in
+// right after the tail, so this is O(1) no matter how many blocks the arena
+// holds.
+//
+// every block past the tail is free (left over from arena_reset or
+// arena_rewind) but its used count is only cleared here, when the tail
+// moves onto it. that keeps reset and rewind O(1).
 static inline arena_valid_block arena_get_valid_block(arena* self, size_t size,
                                                       size_t align) {
     arena_block* current = self->tail;
-    uintptr_t ptr, aligned;
-    size_t size_needed;
-    while (true) {
-        if (!current) {
-            size_t alloc_size = size + align > LIBV_ARENA_BLOCK_SIZE
-                                    ? size + align
-                                    : LIBV_ARENA_BLOCK_SIZE;
-            arena_block* block = arena_block_new(self, alloc_size);
-            if (block == NULL) {
-                return (arena_valid_block){0};
+    arena_valid_block res;
+    if (current) {
+        res = arena_block_fit(current, size, align);
+        if (res.block) {
+            return res;
+        }
+    }
+    if (size >= LIBV_ARENA_SIDE_BLOCK_SIZE) {
+        return arena_side_block(self, size, align);
+    }
+    if (current) {
+        // whatever is left in the tail is given up from here on
+        self->stats.alloc_wasted += current->size - current->used;
+        if (current->next) {
+            current->next->used = 0;
+            res = arena_block_fit(current->next, size, align);
+            if (res.block) {
+                self->tail = current->next;
+                return res;
             }
+        }
+    }
 
-            ptr = (uintptr_t)block->data;
-            aligned = align_up(ptr, align);
-            size_needed = aligned - ptr + size;
+    arena_block* block =
+        arena_block_new(self, arena_next_block_size(self, size + align));
+    if (block == NULL) {
+        return (arena_valid_block){0};
+    }
 
-            libv_assert(
-                size_needed <= block->size,
+    res = arena_block_fit(block, size, align);
+    libv_assert(res.block != NULL,
                 "block created for size %zu but align made block too small",
                 size);
 
-            self->tail->next = block;
-            self->tail = block;
-            current = block;
-            break;
-        }
-
-        ptr = (uintptr_t)(current->data + current->used);
-        aligned = align_up(ptr, align);
-        size_needed = aligned - ptr + size;
-
-        if (size_needed <= current->size - current->used) {
-            break;
-        }
-
-        current = current->next;
+    if (current) {
+        block->next = current->next;
+        current->next = block;
+    } else {
+        self->head = block;
     }
-
-    return (arena_valid_block){current, aligned, size_needed};
+    self->tail = block;
+    return res;
 }
 
-static inline void* arena_alloc_aligned(arena* self, size_t size,
-                                        size_t align) {
+// an arena_new_vm arena never adds blocks, its only block grows instead
+static inline arena_valid_block arena_vm_get_valid_block(arena* self,
+                                                         size_t size,
+                                                         size_t align) {
+    if (self->head == NULL && arena_vm_reserve(self) == LIBV_ERR) {
+        return (arena_valid_block){0};
+    }
+    arena_block* block = self->head;
+    uintptr_t ptr = (uintptr_t)(block->data + block->used);
+    uintptr_t aligned = align_up(ptr, align);
+    size_t size_needed = aligned - ptr + size;
+    if (size_needed < size ||
+        arena_vm_commit(self, block->used + size_needed) == LIBV_ERR) {
+        return (arena_valid_block){0};
+    }
+    return (arena_valid_block){block, aligned, size_needed};
+}
 
-    if (size == 0) {
+LIBV_INLINE_NEVER static void*
+arena_alloc_aligned_slow(arena* self, size_t size, size_t align) {
+    arena_valid_block res = self->reserved
+                                ? arena_vm_get_valid_block(self, size, align)
+                                : arena_get_valid_block(self, size, align);
+    if (res.block == NULL) {
         return NULL;
     }
+    self->stats.alloc_wasted += res.size_needed - size;
+    self->stats.alloc_used += size;
+    res.block->used += res.size_needed;
+    LIBV_ARENA_PROFILE_RECORD(self, size, res.size_needed - size);
+    return (void*)res.aligned;
+}
 
+// the fast path only bumps the tail block, everything else (the first
+// allocation, a full tail, growing the arena) is handled out of line.
+LIBV_INLINE_ALWAYS static inline void*
+arena_alloc_aligned(arena* self, size_t size, size_t align) {
     if (align < sizeof(void*)) {
         align = sizeof(void*);
     }
 
-    if (!is_power_of_two(align)) {
+    if (LIBV_UNLIKELY(size == 0 || !is_power_of_two(align))) {
         return NULL;
     }
 
-    if (arena_maybe_initialize(self, size + align) == LIBV_ERR) {
-        return NULL;
+    arena_block* block = self->tail;
+    if (LIBV_LIKELY(block != NULL)) {
+        uintptr_t ptr = (uintptr_t)(block->data + block->used);
+        uintptr_t aligned = align_up(ptr, align);
+        size_t size_needed = aligned - ptr + size;
+        if (LIBV_LIKELY(size_needed <= block->size - block->used)) {
+            self->stats.alloc_wasted += size_needed - size;
+            self->stats.alloc_used += size;
+            block->used += size_needed;
+            LIBV_ARENA_PROFILE_RECORD(self, size, size_needed - size);
+            return (void*)aligned;
+        }
     }
 
-    arena_valid_block res = arena_get_valid_block(self, size, align);
+    return arena_alloc_aligned_slow(self, size, align);
+}
 
-    if (res.block == NULL) {
-        return NULL;
-    }
+#ifdef LIBV_ARENA_PROFILE
 
-    self->stats.alloc_wasted -= size;
-    self->stats.alloc_used += size;
-    res.block->used += res.size_needed;
-    return (void*)res.aligned;
+static inline void* arena_alloc_aligned_at(arena* self, size_t size,
+                                           size_t align, const char* file,
+                                           int line) {
+    void* ptr = arena_alloc_aligned(self, size, align);
+    if (ptr) {
+        arena_profile_record_site(self, file, line, size);
+    }
+    return ptr;
 }
 
+#define arena_alloc_type(arena_, type_)                                        \
+    arena_alloc_aligned_at(arena_, sizeof(type_), _Alignof(type_), __FILE__,   \
+                           __LINE__)
+
+#define arena_alloc_array(arena_, type_, count_)                               \
+    arena_alloc_aligned_at(arena_, sizeof(type_) * count_, _Alignof(type_),    \
+                           __FILE__, __LINE__)
+
+#else
+
 #define arena_alloc_type(arena_, type_)                                        \
     arena_alloc_aligned(arena_, sizeof(type_), _Alignof(type_))
 
 #define arena_alloc_array(arena_, type_, count_)                               \
     arena_alloc_aligned(arena_, sizeof(type_) * count_, _Alignof(type_))
 
+#endif // LIBV_ARENA_PROFILE
+
 static inline void* arena_alloc(arena* self, size_t size) {
     return arena_alloc_aligned(self, size, _Alignof(max_align_t));
 }
 
-static inline void* arena_memcpy(void* dst, const void* src, size_t size) {
-    unsigned char* d = dst;
-    const unsigned char* s = src;
-    for (; size; --size) {
-        *d++ = *s++;
+// true when ptr is the most recent allocation in the tail block, which is
+// the only allocation that can change size in place.
+static inline bool arena_is_last_alloc(const arena* self, const void* ptr,
+                                       size_t size) {
+    const arena_block* block = self->tail;
+    return ptr != NULL && block != NULL &&
+           (const unsigned char*)ptr + size == block->data + block->used;
+}
+
+// true when ptr is the allocation in the newest side block, which is
+// resized by resizing its block.
+static inline bool arena_is_side_alloc(const arena* self, const void* ptr,
+                                       size_t size) {
+    const arena_block* block = self->side;
+    return ptr != NULL && block != NULL &&
+           (const unsigned char*)ptr + size == block->data + block->used;
+}
+
+static inline void* arena_side_realloc(arena* self, void* ptr,
+                                       size_t old_size, size_t size,
+                                       size_t align) {
+    arena_block* block = self->side;
+    size_t old_block_size = block->size;
+    size_t start = (size_t)((unsigned char*)ptr - block->data);
+    self->stats.alloc_wasted -= old_block_size - old_size;
+    self->stats.alloc_used -= old_size;
+    if (size == 0) {
+        arena_release_side(self, self->num_side - 1);
+        return NULL;
+    }
+
+    arena_block* new_block = realloc(block, sizeof *block + size + align);
+    if (new_block == NULL) {
+        self->stats.alloc_wasted += old_block_size - old_size;
+        self->stats.alloc_used += old_size;
+        return NULL;
     }
-    return dst;
+    // realloc keeps the bytes but not necessarily their alignment
+    unsigned char* aligned =
+        (unsigned char*)align_up((uintptr_t)new_block->data, align);
+    if (aligned != new_block->data + start) {
+        memmove(aligned, new_block->data + start,
+                old_size < size ? old_size : size);
+    }
+    new_block->size = size + align;
+    new_block->used = (size_t)(aligned - new_block->data) + size;
+    self->side = new_block;
+    self->stats.alloc_size += new_block->size;
+    self->stats.alloc_size -= old_block_size;
+    self->stats.alloc_used += size;
+    self->stats.alloc_wasted += new_block->size - size;
+    LIBV_ARENA_PROFILE_PEAK(self);
+    return aligned;
 }
 
 static inline void* arena_realloc_aligned(arena* self, void* ptr,
                                           size_t old_size, size_t size,
                                           size_t align) {
+    if (align < sizeof(void*)) {
+        align = sizeof(void*);
+    }
+
+    if (arena_is_last_alloc(self, ptr, old_size) && is_power_of_two(align) &&
+        ((uintptr_t)ptr & (align - 1)) == 0) {
+        arena_block* block = self->tail;
+        size_t start = (size_t)((unsigned char*)ptr - block->data);
+        if (size <= block->size - start ||
+            (self->reserved &&
+             arena_vm_commit(self, start + size) == LIBV_OK)) {
+            block->used = start + size;
+            self->stats.alloc_used += size;
+            self->stats.alloc_used -= old_size;
+            LIBV_ARENA_PROFILE_PEAK(self);
+            return size == 0 ? NULL : ptr;
+        }
+    }
+
+    if (arena_is_side_alloc(self, ptr, old_size) && is_power_of_two(align)) {
+        return arena_side_realloc(self, ptr, old_size, size, align);
+    }
+
     void* new_ptr = arena_alloc_aligned(self, size, align);
-    if (new_ptr == NULL) {
+    if (new_ptr == NULL && size != 0) {
         return NULL;
     }
-    return arena_memcpy(new_ptr, ptr, old_size);
+    if (ptr != NULL) {
+        if (new_ptr != NULL) {
+            memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+        }
+        self->stats.alloc_used -= old_size;
+        self->stats.alloc_wasted += old_size;
+    }
+    return new_ptr;
 }
 
 static inline void* arena_realloc(arena* self, void* ptr, size_t old_size,
                                   size_t size) {
-    self->stats.alloc_used -= old_size;
-    self->stats.alloc_wasted += old_size;
     return arena_realloc_aligned(self, ptr, old_size, size,
                                  _Alignof(max_align_t));
 }
 
+static inline void* arena_allocator_alloc(void* ctx, size_t size,
+                                          size_t align) {
+    return arena_alloc_aligned(ctx, size, align);
+}
+
+static inline void* arena_allocator_realloc(void* ctx, void* ptr,
+                                            size_t old_size, size_t new_size,
+                                            size_t align) {
+    return arena_realloc_aligned(ctx, ptr, old_size, new_size, align);
+}
+
+// memory is released by arena_reset or arena_destroy. freeing the most recent
+// allocation hands its space back to the arena.
+static inline void arena_allocator_free(void* ctx, void* ptr, size_t size,
+                                        size_t align) {
+    arena* self = ctx;
+    if (arena_is_last_alloc(self, ptr, size) ||
+        arena_is_side_alloc(self, ptr, size)) {
+        arena_realloc_aligned(self, ptr, size, 0, align);
+    }
+}
+
+// a libv_allocator that allocates from self, eg.
+//
+// libv_allocator allocator = arena_allocator(&request_arena);
+// int_vec v = int_vec_new_in(&allocator);
+static inline libv_allocator arena_allocator(arena* self) {
+    return (libv_allocator){
+        .ctx = self,
+        .alloc = arena_allocator_alloc,
+        .realloc = arena_allocator_realloc,
+        .free = arena_allocator_free,
+    };
+}
+
 static inline void arena_reset(arena* self) {
-    libv_assert(self->head, "passed uninitialized arena to arena_reset");
-    for (arena_block* block = self->head; block != NULL; block = block->next) {
-        block->used = 0;
+    libv_assert(self->head || self->side,
+                "passed uninitialized arena to arena_reset");
+    arena_release_side(self, 0);
+    if (self->reserved) {
+        arena_vm_trim(self, LIBV_ARENA_VM_RETAIN);
     }
-    self->stats.alloc_wasted = self->stats.alloc_size;
+    self->stats.alloc_wasted = 0;
     self->stats.alloc_used = 0;
+    if (self->head) {
+        // the rest of the blocks are cleared as the tail reaches them
+        self->head->used = 0;
+    }
     self->tail = self->head;
 }
 
+// like arena_reset, but blocks past the first retain bytes are released so
+// one unusually large round does not pin its memory for good. a retain of 0
+// releases every block, or every page but the first of an arena_new_vm
+// arena.
+static inline void arena_reset_trim(arena* self, size_t retain) {
+    arena_release_side(self, 0);
+    if (self->reserved) {
+        arena_vm_trim(self, retain);
+        retain = SIZE_MAX; // the block itself stays
+    }
+    arena_block* prev = NULL;
+    arena_block* current = self->head;
+    size_t kept = 0;
+    while (current && kept + current->size <= retain) {
+        kept += current->size;
+        prev = current;
+        current = current->next;
+    }
+    if (prev) {
+        prev->next = NULL;
+    } else {
+        self->head = NULL;
+    }
+    while (current) {
+        arena_block* next = current->next;
+        self->stats.alloc_size -= current->size;
+        --self->stats.num_blocks;
+        arena_block_destroy(current);
+        current = next;
+    }
+    if (self->head) {
+        self->head->used = 0;
+    }
+    self->tail = self->head;
+    self->stats.alloc_wasted = 0;
+    self->stats.alloc_used = 0;
+}
+
+// a position in the arena. rewinding to it frees everything allocated after
+// it was taken. markers must be rewound in the reverse order they were taken
+// and are invalidated by arena_reset and arena_destroy.
+typedef struct {
+    arena_block* block;
+    size_t num_side;
+    size_t used;
+    size_t alloc_used;
+    size_t alloc_wasted;
+} arena_marker;
+
+static inline arena_marker arena_mark(const arena* self) {
+    return (arena_marker){self->tail, self->num_side,
+                          self->tail ? self->tail->used : 0,
+                          self->stats.alloc_used, self->stats.alloc_wasted};
+}
+
+static inline void arena_rewind(arena* self, arena_marker marker) {
+    // side blocks created since the marker are freed, regular blocks stay in
+    // the list and are reused
+    arena_release_side(self, marker.num_side);
+    self->stats.alloc_used = marker.alloc_used;
+    self->stats.alloc_wasted = marker.alloc_wasted;
+    if (self->head == NULL) {
+        return;
+    }
+    if (marker.block == NULL) {
+        // taken before the first allocation
+        marker.block = self->head;
+    }
+    marker.block->used = marker.used;
+    self->tail = marker.block;
+}
+
+// a scope that rewinds its arena when it ends. scopes nest.
+typedef struct {
+    arena* arena;
+    arena_marker marker;
+} arena_scope;
+
+static inline arena_scope arena_scope_begin(arena* self) {
+    return (arena_scope){self, arena_mark(self)};
+}
+
+static inline void arena_scope_end(arena_scope* scope) {
+    arena_rewind(scope->arena, scope->marker);
+}
+
+// per thread scratch arenas for temporaries. a function that takes an output
+// arena passes it as a conflict so its scratch space is never the arena it
+// is returning results in, eg.
+//
+// arena_scope scratch = arena_scratch_begin(&out, 1);
+// ... allocate temporaries from scratch.arena, results from out
+// arena_scope_end(&scratch);
+#ifndef LIBV_ARENA_SCRATCH_COUNT
+#define LIBV_ARENA_SCRATCH_COUNT 2
+#endif // LIBV_ARENA_SCRATCH_COUNT
+
+static _Thread_local arena arena_scratch_arenas[LIBV_ARENA_SCRATCH_COUNT];
+
+static inline arena_scope arena_scratch_begin(arena* const* conflicts,
+                                              size_t num_conflicts) {
+    for (size_t i = 0; i < LIBV_ARENA_SCRATCH_COUNT; ++i) {
+        arena* candidate = &arena_scratch_arenas[i];
+        bool conflicted = false;
+        for (size_t j = 0; j < num_conflicts; ++j) {
+            if (conflicts[j] == candidate) {
+                conflicted = true;
+                break;
+            }
+        }
+        if (!conflicted) {
+            return arena_scope_begin(candidate);
+        }
+    }
+    libv_panic("all %d scratch arenas conflict\n", LIBV_ARENA_SCRATCH_COUNT);
+}
+
+// frees the calling thread's scratch arenas, call before a thread exits
+static inline void arena_scratch_release(void) {
+    for (size_t i = 0; i < LIBV_ARENA_SCRATCH_COUNT; ++i) {
+        arena_destroy(&arena_scratch_arenas[i]);
+        arena_scratch_arenas[i] = arena_new();
+    }
+}
+
 LIBV_END
 
 #endif // __LIBV_ARENA_H__
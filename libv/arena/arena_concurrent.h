@@ -0,0 +1,342 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2026, vincer2040
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// a thread safe arena. threads do not allocate from the shared arena
+// directly, each one bump allocates from a private chunk (an arena_local)
+// that is carved out of the shared blocks with a single atomic fetch-add.
+// reset and destroy are global and must not race with allocation.
+
+#ifndef __LIBV_ARENA_CONCURRENT_H__
+
+#define __LIBV_ARENA_CONCURRENT_H__
+
+#include "libv/arena/arena.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+LIBV_BEGIN
+
+// the amount each thread carves out of the shared arena at a time
+#ifndef LIBV_ARENA_CHUNK_SIZE
+#define LIBV_ARENA_CHUNK_SIZE (16 * 1024)
+#endif // LIBV_ARENA_CHUNK_SIZE
+
+typedef struct arena_concurrent_block arena_concurrent_block;
+
+struct arena_concurrent_block {
+    arena_concurrent_block* next;
+    size_t size;
+    atomic_size_t used;   // may run past size once the block is exhausted
+    atomic_size_t carved; // bytes actually handed out
+    unsigned char data[];
+};
+
+typedef struct {
+    arena_concurrent_block* _Atomic current;
+    arena_concurrent_block* head;
+    // bumped by reset so arena_locals drop chunks from before the reset
+    atomic_size_t epoch;
+    atomic_size_t alloc_used;
+    // padding and chunk tails given up by arena_locals
+    atomic_size_t alloc_wasted;
+    // everything below is guarded by lock
+    pthread_mutex_t lock;
+    size_t num_blocks;
+    size_t alloc_size;
+    size_t block_size;
+} arena_concurrent;
+
+static inline int arena_concurrent_init(arena_concurrent* self) {
+    *self = (arena_concurrent){0};
+    if (pthread_mutex_init(&self->lock, NULL) != 0) {
+        return LIBV_ERR;
+    }
+    return LIBV_OK;
+}
+
+static inline void arena_concurrent_destroy(arena_concurrent* self) {
+    arena_concurrent_block* current = self->head;
+    while (current) {
+        arena_concurrent_block* next = current->next;
+        free(current);
+        current = next;
+    }
+    pthread_mutex_destroy(&self->lock);
+    *self = (arena_concurrent){0};
+}
+
+// must not be called while any thread is allocating. every arena_local
+// notices the reset on its next allocation and drops its chunk.
+static inline void arena_concurrent_reset(arena_concurrent* self) {
+    pthread_mutex_lock(&self->lock);
+    if (self->head) {
+        atomic_store(&self->head->used, 0);
+        atomic_store(&self->head->carved, 0);
+    }
+    atomic_store(&self->current, self->head);
+    atomic_store(&self->alloc_used, 0);
+    atomic_store(&self->alloc_wasted, 0);
+    atomic_fetch_add(&self->epoch, 1);
+    pthread_mutex_unlock(&self->lock);
+}
+
+// follows arena_stats: alloc_size - alloc_used - alloc_wasted is what can
+// still be carved. alloc_wasted is the end of the blocks the arena has moved
+// past plus the padding and unused ends of chunks threads have moved past.
+// the chunk a thread is still allocating from counts as used in full.
+// only exact while no thread is allocating.
+static inline arena_stats arena_concurrent_stats(arena_concurrent* self) {
+    arena_stats stats = {0};
+    pthread_mutex_lock(&self->lock);
+    stats.num_blocks = self->num_blocks;
+    stats.alloc_size = self->alloc_size;
+    arena_concurrent_block* current = atomic_load(&self->current);
+    for (arena_concurrent_block* block = self->head;
+         block && block != current; block = block->next) {
+        stats.alloc_wasted += block->size - atomic_load(&block->carved);
+    }
+    pthread_mutex_unlock(&self->lock);
+    stats.alloc_used = atomic_load(&self->alloc_used);
+    stats.alloc_wasted += atomic_load(&self->alloc_wasted);
+    return stats;
+}
+
+// called with the lock held once block (the block the caller failed to carve
+// from) is exhausted. moves current on to the next free block, or links in a
+// new one.
+static inline int arena_concurrent_advance(arena_concurrent* self,
+                                           arena_concurrent_block* block,
+                                           size_t size) {
+    if (atomic_load(&self->current) != block) {
+        // another thread already advanced
+        return LIBV_OK;
+    }
+    if (block && block->next && block->next->size >= size) {
+        atomic_store(&block->next->used, 0);
+        atomic_store(&block->next->carved, 0);
+        atomic_store(&self->current, block->next);
+        return LIBV_OK;
+    }
+
+    size_t block_size = self->block_size ? self->block_size
+                                         : 4 * LIBV_ARENA_CHUNK_SIZE;
+    self->block_size = block_size < LIBV_ARENA_MAX_BLOCK_SIZE / 2
+                           ? block_size * 2
+                           : LIBV_ARENA_MAX_BLOCK_SIZE;
+    if (block_size < size) {
+        block_size = size;
+    }
+
+    arena_concurrent_block* fresh = malloc(sizeof *fresh + block_size);
+    if (fresh == NULL) {
+        return LIBV_ERR;
+    }
+    fresh->size = block_size;
+    atomic_init(&fresh->used, 0);
+    atomic_init(&fresh->carved, 0);
+    if (block) {
+        fresh->next = block->next;
+        block->next = fresh;
+    } else {
+        fresh->next = self->head;
+        self->head = fresh;
+    }
+    self->num_blocks++;
+    self->alloc_size += block_size;
+    atomic_store(&self->current, fresh);
+    return LIBV_OK;
+}
+
+// carves size bytes out of the shared arena. lock free unless the current
+// block is exhausted.
+static inline unsigned char* arena_concurrent_carve(arena_concurrent* self,
+                                                    size_t size) {
+    while (true) {
+        arena_concurrent_block* block =
+            atomic_load_explicit(&self->current, memory_order_acquire);
+        if (block) {
+            size_t start = atomic_fetch_add_explicit(&block->used, size,
+                                                     memory_order_relaxed);
+            if (start <= block->size && size <= block->size - start) {
+                atomic_fetch_add_explicit(&block->carved, size,
+                                          memory_order_relaxed);
+                atomic_fetch_add_explicit(&self->alloc_used, size,
+                                          memory_order_relaxed);
+                return block->data + start;
+            }
+        }
+        pthread_mutex_lock(&self->lock);
+        int res = arena_concurrent_advance(self, block, size);
+        pthread_mutex_unlock(&self->lock);
+        if (res == LIBV_ERR) {
+            return NULL;
+        }
+    }
+}
+
+// a thread's handle on a concurrent arena. it is not thread safe itself, every
+// thread needs its own. memory belongs to the shared arena, so there is
+// nothing to free.
+typedef struct {
+    arena_concurrent* arena;
+    unsigned char* cur;
+    unsigned char* end;
+    size_t epoch;
+    size_t alloc_used; // bytes this thread has allocated
+    size_t chunk_used; // alloc_used when the current chunk was carved
+} arena_local;
+
+static inline arena_local arena_local_new(arena_concurrent* shared) {
+    return (arena_local){shared, NULL, NULL, 0, 0, 0};
+}
+
+// moves the part of a chunk that was carved but never allocated, padding and
+// the unused end, from the shared arena's used bytes to its wasted bytes
+static inline void arena_local_give_up(arena_local* self, size_t lost) {
+    atomic_fetch_sub_explicit(&self->arena->alloc_used, lost,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&self->arena->alloc_wasted, lost,
+                              memory_order_relaxed);
+}
+
+LIBV_INLINE_NEVER static void*
+arena_local_alloc_slow(arena_local* self, size_t size, size_t align) {
+    size_t epoch =
+        atomic_load_explicit(&self->arena->epoch, memory_order_relaxed);
+    size_t needed = size + align;
+
+    if (epoch != self->epoch) {
+        self->cur = self->end = NULL;
+        self->epoch = epoch;
+    }
+
+    // a large allocation gets a chunk of its own so the current chunk is not
+    // thrown away
+    if (needed > LIBV_ARENA_CHUNK_SIZE / 2) {
+        unsigned char* chunk = arena_concurrent_carve(self->arena, needed);
+        if (chunk == NULL) {
+            return NULL;
+        }
+        self->alloc_used += size;
+        arena_local_give_up(self, needed - size);
+        return (void*)align_up((uintptr_t)chunk, align);
+    }
+
+    unsigned char* chunk =
+        arena_concurrent_carve(self->arena, LIBV_ARENA_CHUNK_SIZE);
+    if (chunk == NULL) {
+        return NULL;
+    }
+    // a chunk from before a reset was already dropped above
+    if (self->end) {
+        arena_local_give_up(self, LIBV_ARENA_CHUNK_SIZE -
+                                      (self->alloc_used - self->chunk_used));
+    }
+    self->end = chunk + LIBV_ARENA_CHUNK_SIZE;
+    self->chunk_used = self->alloc_used;
+    uintptr_t aligned = align_up((uintptr_t)chunk, align);
+    self->cur = (unsigned char*)(aligned + size);
+    self->alloc_used += size;
+    return (void*)aligned;
+}
+
+LIBV_INLINE_ALWAYS static inline void*
+arena_local_alloc_aligned(arena_local* self, size_t size, size_t align) {
+    if (align < sizeof(void*)) {
+        align = sizeof(void*);
+    }
+
+    if (LIBV_UNLIKELY(size == 0 || !is_power_of_two(align))) {
+        return NULL;
+    }
+
+    uintptr_t aligned = align_up((uintptr_t)self->cur, align);
+    if (LIBV_LIKELY(aligned + size <= (uintptr_t)self->end &&
+                    atomic_load_explicit(&self->arena->epoch,
+                                         memory_order_relaxed) ==
+                        self->epoch)) {
+        self->cur = (unsigned char*)(aligned + size);
+        self->alloc_used += size;
+        return (void*)aligned;
+    }
+
+    return arena_local_alloc_slow(self, size, align);
+}
+
+#define arena_local_alloc_type(local_, type_)                                  \
+    arena_local_alloc_aligned(local_, sizeof(type_), _Alignof(type_))
+
+#define arena_local_alloc_array(local_, type_, count_)                         \
+    arena_local_alloc_aligned(local_, sizeof(type_) * count_, _Alignof(type_))
+
+static inline void* arena_local_alloc(arena_local* self, size_t size) {
+    return arena_local_alloc_aligned(self, size, _Alignof(max_align_t));
+}
+
+static inline void* arena_local_allocator_alloc(void* ctx, size_t size,
+                                                size_t align) {
+    return arena_local_alloc_aligned(ctx, size, align);
+}
+
+static inline void* arena_local_allocator_realloc(void* ctx, void* ptr,
+                                                  size_t old_size,
+                                                  size_t new_size,
+                                                  size_t align) {
+    void* new_ptr = arena_local_alloc_aligned(ctx, new_size, align);
+    if (new_ptr != NULL && ptr != NULL) {
+        memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    }
+    return new_ptr;
+}
+
+// memory is released by arena_concurrent_reset or arena_concurrent_destroy
+static inline void arena_local_allocator_free(void* ctx, void* ptr,
+                                              size_t size, size_t align) {
+    LIBV_UNUSED(ctx);
+    LIBV_UNUSED(ptr);
+    LIBV_UNUSED(size);
+    LIBV_UNUSED(align);
+}
+
+// a libv_allocator that allocates through a thread's arena_local
+static inline libv_allocator arena_local_allocator(arena_local* self) {
+    return (libv_allocator){
+        .ctx = self,
+        .alloc = arena_local_allocator_alloc,
+        .realloc = arena_local_allocator_realloc,
+        .free = arena_local_allocator_free,
+    };
+}
+
+LIBV_END
+
+#endif // __LIBV_ARENA_CONCURRENT_H__
@@ -0,0 +1,175 @@
+#define LIBV_ARENA_IMPLEMENTATION
+#include "arena_concurrent.h"
+#include "libv/vtest/vtest.h"
+#include <stdint.h>
+#include <string.h>
+
+// what the shared arena can still carve: the rest of the current block and
+// every block after it
+static size_t free_bytes(arena_concurrent* a) {
+    arena_concurrent_block* block = atomic_load(&a->current);
+    if (block == NULL) {
+        return 0;
+    }
+    size_t free = block->size - atomic_load(&block->carved);
+    for (block = block->next; block; block = block->next) {
+        free += block->size;
+    }
+    return free;
+}
+
+static void assert_stats_invariant(arena_concurrent* a) {
+    arena_stats stats = arena_concurrent_stats(a);
+    assert_true(stats.alloc_used + stats.alloc_wasted <= stats.alloc_size);
+    assert_uint_eq(stats.alloc_size - stats.alloc_used - stats.alloc_wasted,
+                   free_bytes(a));
+}
+
+TEST(arena_concurrent, single_thread) {
+    arena_concurrent a;
+    assert_int_eq(arena_concurrent_init(&a), LIBV_OK);
+    arena_local l = arena_local_new(&a);
+
+    int* x = arena_local_alloc_type(&l, int);
+    assert_ptr_nonnull(x);
+    *x = 42;
+
+    double* d = arena_local_alloc_array(&l, double, 10);
+    assert_ptr_nonnull(d);
+    assert_uint_eq((uintptr_t)d % _Alignof(double), 0);
+
+    void* big = arena_local_alloc(&l, LIBV_ARENA_CHUNK_SIZE * 4);
+    assert_ptr_nonnull(big);
+    memset(big, 0xAB, LIBV_ARENA_CHUNK_SIZE * 4);
+
+    assert_ptr_null(arena_local_alloc(&l, 0));
+    assert_int_eq(*x, 42);
+
+    arena_stats stats = arena_concurrent_stats(&a);
+    assert_true(stats.num_blocks > 0);
+    assert_true(stats.alloc_used >= l.alloc_used);
+    assert_stats_invariant(&a);
+
+    arena_concurrent_destroy(&a);
+}
+
+TEST(arena_concurrent, stats) {
+    arena_concurrent a;
+    assert_int_eq(arena_concurrent_init(&a), LIBV_OK);
+    arena_local l = arena_local_new(&a);
+
+    // a char then a double keeps leaving padding behind
+    for (int i = 0; i < 10000; ++i) {
+        assert_ptr_nonnull(arena_local_alloc_type(&l, char));
+        assert_ptr_nonnull(arena_local_alloc_type(&l, double));
+    }
+    arena_stats stats = arena_concurrent_stats(&a);
+    assert_true(stats.alloc_wasted > 0);
+    assert_true(stats.alloc_size - stats.alloc_used - stats.alloc_wasted > 0);
+    // everything but the live chunk is accounted for exactly
+    size_t live = LIBV_ARENA_CHUNK_SIZE - (l.alloc_used - l.chunk_used);
+    assert_uint_eq(stats.alloc_used, l.alloc_used + live);
+    assert_stats_invariant(&a);
+
+    assert_ptr_nonnull(arena_local_alloc(&l, LIBV_ARENA_CHUNK_SIZE));
+    assert_stats_invariant(&a);
+
+    arena_concurrent_reset(&a);
+    stats = arena_concurrent_stats(&a);
+    assert_uint_eq(stats.alloc_used, 0);
+    assert_uint_eq(stats.alloc_wasted, 0);
+    assert_stats_invariant(&a);
+
+    assert_ptr_nonnull(arena_local_alloc_type(&l, int));
+    assert_stats_invariant(&a);
+
+    arena_concurrent_destroy(&a);
+}
+
+#define NUM_THREADS 4
+#define NUM_ALLOCS 50000
+
+typedef struct {
+    arena_concurrent* arena;
+    uint64_t id;
+    uint64_t* ptrs[NUM_ALLOCS];
+    bool ok;
+} worker;
+
+static void* worker_run(void* arg) {
+    worker* w = arg;
+    arena_local l = arena_local_new(w->arena);
+    for (uint64_t i = 0; i < NUM_ALLOCS; ++i) {
+        // mix in the odd large allocation
+        size_t count = i % 1000 == 0 ? 4096 : 2;
+        uint64_t* p = arena_local_alloc_array(&l, uint64_t, count);
+        if (p == NULL) {
+            return NULL;
+        }
+        p[0] = w->id;
+        p[count - 1] = i;
+        w->ptrs[i] = p;
+    }
+    w->ok = true;
+    for (uint64_t i = 0; i < NUM_ALLOCS; ++i) {
+        size_t count = i % 1000 == 0 ? 4096 : 2;
+        if (w->ptrs[i][0] != w->id || w->ptrs[i][count - 1] != i) {
+            w->ok = false;
+        }
+    }
+    return NULL;
+}
+
+static void run_workers(arena_concurrent* a) {
+    static worker workers[NUM_THREADS];
+    pthread_t ids[NUM_THREADS];
+    for (uint64_t i = 0; i < NUM_THREADS; ++i) {
+        workers[i].arena = a;
+        workers[i].id = i;
+        workers[i].ok = false;
+        assert_int_eq(pthread_create(&ids[i], NULL, worker_run, &workers[i]),
+                      0);
+    }
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        pthread_join(ids[i], NULL);
+        assert_true(workers[i].ok);
+    }
+}
+
+TEST(arena_concurrent, threads) {
+    arena_concurrent a;
+    assert_int_eq(arena_concurrent_init(&a), LIBV_OK);
+
+    run_workers(&a);
+    arena_stats stats = arena_concurrent_stats(&a);
+    assert_true(stats.alloc_used >= NUM_THREADS * NUM_ALLOCS * 16);
+    assert_stats_invariant(&a);
+
+    // after a reset the blocks are handed out again
+    arena_concurrent_reset(&a);
+    assert_uint_eq(arena_concurrent_stats(&a).alloc_used, 0);
+
+    run_workers(&a);
+    assert_true(arena_concurrent_stats(&a).num_blocks <= stats.num_blocks + 1);
+    assert_stats_invariant(&a);
+
+    arena_concurrent_destroy(&a);
+}
+
+TEST(arena_concurrent, local_sees_reset) {
+    arena_concurrent a;
+    assert_int_eq(arena_concurrent_init(&a), LIBV_OK);
+    arena_local l = arena_local_new(&a);
+
+    unsigned char* first = arena_local_alloc(&l, 16);
+    arena_local_alloc(&l, 16);
+
+    arena_concurrent_reset(&a);
+
+    // the local drops its old chunk and starts over at the first block
+    assert_true(arena_local_alloc(&l, 16) == first);
+
+    arena_concurrent_destroy(&a);
+}
+
+VTEST_MAIN()
@@ -0,0 +1,109 @@
+#define LIBV_ARENA_IMPLEMENTATION
+#define LIBV_ARENA_PROFILE
+#include "arena.h"
+#include "libv/vtest/vtest.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    int id;
+    double weight;
+} item;
+
+TEST(arena_profile, peak) {
+    arena a = arena_new();
+
+    arena_alloc(&a, 1000);
+    arena_alloc(&a, 2000);
+    arena_reset(&a);
+    arena_alloc(&a, 100);
+
+    assert_ptr_nonnull(a.profile);
+    assert_uint_eq(a.profile->peak_used, 3000);
+    assert_uint_eq(a.stats.alloc_used, 100);
+
+    // growing in place raises the peak too
+    void* ptr = arena_alloc(&a, 100);
+    assert_true(arena_realloc(&a, ptr, 100, 3500) == ptr);
+    assert_uint_eq(a.profile->peak_used, 3600);
+
+    arena_destroy(&a);
+    assert_ptr_null(a.profile);
+}
+
+TEST(arena_profile, histogram) {
+    arena a = arena_new();
+
+    arena_alloc(&a, 1);
+    arena_alloc(&a, 16);
+    arena_alloc(&a, 31);
+    arena_alloc(&a, 1000);
+
+    assert_uint_eq(a.profile->histogram[0], 1);
+    assert_uint_eq(a.profile->histogram[4], 2);
+    assert_uint_eq(a.profile->histogram[9], 1);
+
+    arena_destroy(&a);
+}
+
+TEST(arena_profile, padding) {
+    arena a = arena_new();
+
+    arena_alloc_aligned(&a, 8, 8);
+    assert_uint_eq(a.profile->padding, 0);
+    arena_alloc_aligned(&a, 1, 8);
+    arena_alloc_aligned(&a, 8, 64);
+    assert_true(a.profile->padding > 0);
+    assert_uint_eq(a.profile->padding, a.stats.alloc_wasted);
+
+    arena_destroy(&a);
+}
+
+TEST(arena_profile, sites) {
+    arena a = arena_new();
+
+    for (int i = 0; i < 10; ++i) {
+        assert_ptr_nonnull(arena_alloc_type(&a, item));
+    }
+    assert_ptr_nonnull(arena_alloc_array(&a, item, 5));
+
+    size_t found = 0;
+    for (size_t i = 0; i < LIBV_ARENA_PROFILE_SITES; ++i) {
+        const arena_profile_site* site = &a.profile->sites[i];
+        if (site->file == NULL) {
+            continue;
+        }
+        assert_str_eq(site->file, __FILE__);
+        if (site->count == 10) {
+            assert_uint_eq(site->bytes, 10 * sizeof(item));
+        } else {
+            assert_uint_eq(site->count, 1);
+            assert_uint_eq(site->bytes, 5 * sizeof(item));
+        }
+        ++found;
+    }
+    assert_uint_eq(found, 2);
+
+    arena_destroy(&a);
+}
+
+TEST(arena_profile, dump_json) {
+    arena a = arena_new();
+    assert_ptr_nonnull(arena_alloc_array(&a, item, 4));
+
+    char buf[4096] = {0};
+    FILE* out = fmemopen(buf, sizeof buf, "w");
+    assert_ptr_nonnull(out);
+    assert_int_eq(arena_profile_dump_json(&a, out), LIBV_OK);
+    fclose(out);
+
+    assert_true(strstr(buf, "\"peak_used\":64") != NULL);
+    assert_true(strstr(buf, "\"histogram\":[{\"min\":64,\"max\":127,"
+                            "\"count\":1}]") != NULL);
+    assert_true(strstr(buf, "\"line\":") != NULL);
+    assert_true(strstr(buf, "\"bytes\":64}") != NULL);
+
+    arena_destroy(&a);
+}
+
+VTEST_MAIN()
@@ -1,5 +1,10 @@
+#define LIBV_ARENA_IMPLEMENTATION
 #include "arena.h"
+#include "libv/vec/vec.h"
+#include "libv/vmap/vmap.h"
+#include "libv/vstr/vstr.h"
 #include "libv/vtest/vtest.h"
+#include <pthread.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -443,4 +448,402 @@ TEST(arena, stress_alloc_reset) {
     arena_destroy(&a);
 }
 
+TEST(arena, geometric_growth) {
+    arena a = arena_new();
+
+    // 10MB of small allocations should need a handful of blocks, not
+    // one block per LIBV_ARENA_BLOCK_SIZE
+    for (int i = 0; i < 10 * 1024; i++) {
+        void* ptr = arena_alloc(&a, 1024);
+        assert_ptr_nonnull(ptr);
+        memset(ptr, i & 0xFF, 1024);
+    }
+
+    assert_true(a.stats.num_blocks < 32);
+    assert_true(a.tail->size <= LIBV_ARENA_MAX_BLOCK_SIZE);
+    assert_uint_eq(a.stats.alloc_used, 10 * 1024 * 1024);
+
+    arena_destroy(&a);
+}
+
+TEST(arena, reset_reuses_blocks_in_order) {
+    arena a = arena_new();
+
+    for (int i = 0; i < 1000; i++) {
+        assert_ptr_nonnull(arena_alloc(&a, 512));
+    }
+    size_t num_blocks = a.stats.num_blocks;
+
+    arena_reset(&a);
+
+    // the same workload after a reset must not need new blocks
+    for (int i = 0; i < 1000; i++) {
+        assert_ptr_nonnull(arena_alloc(&a, 512));
+    }
+    assert_uint_eq(a.stats.num_blocks, num_blocks);
+
+    // an allocation too large for the next free block gets a new block
+    // linked in after the tail, the remaining free blocks stay in the list
+    arena_reset(&a);
+    assert_ptr_nonnull(arena_alloc(&a, LIBV_ARENA_BLOCK_SIZE * 2));
+    assert_uint_eq(a.stats.num_blocks, num_blocks + 1);
+
+    size_t listed = 0;
+    for (arena_block* block = a.head; block != NULL; block = block->next) {
+        listed++;
+    }
+    assert_uint_eq(listed, num_blocks + 1);
+
+    arena_destroy(&a);
+}
+
+TEST(arena, realloc_in_place) {
+    arena a = arena_new();
+
+    arena_alloc(&a, 32);
+    unsigned char* ptr = arena_alloc(&a, 100);
+    memset(ptr, 0x5A, 100);
+
+    // growing the last allocation keeps its address
+    unsigned char* grown = arena_realloc(&a, ptr, 100, 1000);
+    assert_true(grown == ptr);
+    for (int i = 0; i < 100; i++) {
+        assert_uint_eq(grown[i], 0x5A);
+    }
+    assert_uint_eq(a.stats.alloc_used, 32 + 1000);
+
+    // and so does shrinking it, the space is handed back to the block
+    size_t used = a.tail->used;
+    unsigned char* shrunk = arena_realloc(&a, grown, 1000, 10);
+    assert_true(shrunk == ptr);
+    assert_uint_eq(a.tail->used, used - 990);
+    assert_uint_eq(a.stats.alloc_used, 32 + 10);
+
+    // the next allocation reuses the released space
+    unsigned char* next = arena_alloc_aligned(&a, 8, 8);
+    assert_true(next == ptr + 16);
+
+    arena_destroy(&a);
+}
+
+TEST(arena, realloc_growing_buffer) {
+    arena a = arena_new();
+
+    size_t capacity = 16;
+    unsigned char* buf = arena_alloc(&a, capacity);
+    for (size_t i = 0; i < 64 * 1024; i++) {
+        if (i == capacity) {
+            buf = arena_realloc(&a, buf, capacity, capacity * 2);
+            assert_ptr_nonnull(buf);
+            capacity *= 2;
+        }
+        buf[i] = (unsigned char)i;
+    }
+
+    for (size_t i = 0; i < 64 * 1024; i++) {
+        assert_uint_eq(buf[i], (unsigned char)i);
+    }
+    assert_uint_eq(a.stats.alloc_used, capacity);
+
+    arena_destroy(&a);
+}
+
+TEST(arena, mark_rewind) {
+    arena a = arena_new();
+
+    arena_alloc(&a, 100);
+    size_t used = a.stats.alloc_used;
+    size_t wasted = a.stats.alloc_wasted;
+    arena_marker marker = arena_mark(&a);
+
+    unsigned char* first = arena_alloc(&a, 64);
+    arena_alloc(&a, 64);
+    assert_uint_eq(a.stats.alloc_used, used + 128);
+
+    arena_rewind(&a, marker);
+    assert_uint_eq(a.stats.alloc_used, used);
+    assert_uint_eq(a.stats.alloc_wasted, wasted);
+
+    // the space is handed out again
+    assert_true(arena_alloc(&a, 64) == first);
+
+    arena_destroy(&a);
+}
+
+TEST(arena, rewind_across_blocks) {
+    arena a = arena_new();
+
+    arena_alloc(&a, 16);
+    arena_marker marker = arena_mark(&a);
+    arena_block* block = a.tail;
+
+    for (int i = 0; i < 1000; i++) {
+        assert_ptr_nonnull(arena_alloc(&a, 1024));
+    }
+    size_t num_blocks = a.stats.num_blocks;
+    assert_true(num_blocks > 1);
+
+    arena_rewind(&a, marker);
+    assert_true(a.tail == block);
+    assert_uint_eq(a.stats.alloc_used, 16);
+
+    // the blocks created after the marker are reused
+    for (int i = 0; i < 1000; i++) {
+        assert_ptr_nonnull(arena_alloc(&a, 1024));
+    }
+    assert_uint_eq(a.stats.num_blocks, num_blocks);
+
+    arena_destroy(&a);
+}
+
+TEST(arena, mark_empty_arena) {
+    arena a = arena_new();
+
+    arena_marker marker = arena_mark(&a);
+    arena_alloc(&a, 100);
+    arena_rewind(&a, marker);
+
+    assert_uint_eq(a.stats.alloc_used, 0);
+    assert_ptr_nonnull(arena_alloc(&a, 100));
+
+    arena_destroy(&a);
+}
+
+TEST(arena, nested_scopes) {
+    arena a = arena_new();
+
+    arena_scope outer = arena_scope_begin(&a);
+    arena_alloc(&a, 100);
+    size_t used = a.stats.alloc_used;
+
+    arena_scope inner = arena_scope_begin(&a);
+    arena_alloc(&a, 5000);
+    arena_scope_end(&inner);
+    assert_uint_eq(a.stats.alloc_used, used);
+
+    arena_scope_end(&outer);
+    assert_uint_eq(a.stats.alloc_used, 0);
+
+    arena_destroy(&a);
+}
+
+TEST(arena, scratch) {
+    arena_scope first = arena_scratch_begin(NULL, 0);
+    assert_ptr_nonnull(arena_alloc(first.arena, 64));
+
+    // a scratch arena that conflicts with the first hands out the other one
+    arena_scope second = arena_scratch_begin(&first.arena, 1);
+    assert_true(second.arena != first.arena);
+    assert_ptr_nonnull(arena_alloc(second.arena, 64));
+
+    arena_scope_end(&second);
+    arena_scope_end(&first);
+    assert_uint_eq(first.arena->stats.alloc_used, 0);
+    assert_uint_eq(second.arena->stats.alloc_used, 0);
+
+    arena_scratch_release();
+}
+
+TEST(arena, reset_trim) {
+    arena a = arena_new();
+
+    for (int i = 0; i < 100; ++i) {
+        assert_ptr_nonnull(arena_alloc(&a, 4000));
+    }
+    size_t num_blocks = a.stats.num_blocks;
+    assert_true(num_blocks > 2);
+
+    // the first two blocks are 4KB and 8KB
+    arena_reset_trim(&a, LIBV_ARENA_BLOCK_SIZE * 3);
+    assert_uint_eq(a.stats.num_blocks, 2);
+    assert_uint_eq(a.stats.alloc_size, LIBV_ARENA_BLOCK_SIZE * 3);
+    assert_uint_eq(a.stats.alloc_used, 0);
+    assert_uint_eq(a.stats.alloc_wasted, 0);
+
+    void* ptr = arena_alloc(&a, 100);
+    assert_true((unsigned char*)ptr >= a.head->data &&
+                (unsigned char*)ptr < a.head->data + a.head->size);
+
+    arena_reset_trim(&a, 0);
+    assert_ptr_null(a.head);
+    assert_uint_eq(a.stats.num_blocks, 0);
+    assert_uint_eq(a.stats.alloc_size, 0);
+    assert_ptr_nonnull(arena_alloc(&a, 100));
+
+    arena_destroy(&a);
+}
+
+TEST(arena, block_pool) {
+    arena a = arena_new();
+    assert_ptr_nonnull(arena_alloc(&a, 100));
+    arena_block* block = a.head;
+    arena_destroy(&a);
+
+    // the freed block is handed to the next arena instead of malloc's
+    arena b = arena_new();
+    assert_ptr_nonnull(arena_alloc(&b, 100));
+    assert_true(b.head == block);
+    assert_uint_eq(b.stats.alloc_used, 100);
+    arena_destroy(&b);
+
+    // oversized blocks are not recycled
+    assert_int_eq(arena_block_class(LIBV_ARENA_BLOCK_SIZE), 0);
+    assert_int_eq(arena_block_class(LIBV_ARENA_BLOCK_SIZE * 4), 2);
+    assert_int_eq(arena_block_class(LIBV_ARENA_MAX_BLOCK_SIZE * 2), -1);
+    assert_int_eq(arena_block_class(LIBV_ARENA_BLOCK_SIZE + 8), -1);
+
+    arena_pool_release();
+    assert_true(arena_block_shared_pool.bytes > 0);
+    arena_pool_trim();
+    assert_uint_eq(arena_block_shared_pool.bytes, 0);
+}
+
+static void* block_pool_thread(void* arg) {
+    LIBV_UNUSED(arg);
+    arena a = arena_new();
+    assert_ptr_nonnull(arena_alloc(&a, 100));
+    arena_destroy(&a);
+    // exits without arena_pool_release
+    return NULL;
+}
+
+TEST(arena, block_pool_thread_exit) {
+    arena_pool_trim();
+    assert_uint_eq(arena_block_shared_pool.bytes, 0);
+
+    pthread_t thread;
+    assert_int_eq(pthread_create(&thread, NULL, block_pool_thread, NULL), 0);
+    assert_int_eq(pthread_join(thread, NULL), 0);
+
+    // the exiting thread's cache was handed to the shared pool
+    assert_uint_eq(arena_block_shared_pool.bytes, LIBV_ARENA_BLOCK_SIZE);
+    arena_pool_trim();
+}
+
+TEST(arena, side_blocks) {
+    arena a = arena_new();
+
+    assert_ptr_nonnull(arena_alloc(&a, 100));
+    arena_block* tail = a.tail;
+
+    // the big allocation neither becomes the tail nor strands it
+    void* big = arena_alloc(&a, LIBV_ARENA_MAX_BLOCK_SIZE);
+    assert_ptr_nonnull(big);
+    memset(big, 0xAB, LIBV_ARENA_MAX_BLOCK_SIZE);
+    assert_true(a.tail == tail);
+    assert_uint_eq(a.num_side, 1);
+    assert_uint_eq(a.stats.num_blocks, 2);
+
+    unsigned char* next = arena_alloc(&a, 100);
+    assert_true(next > tail->data && next < tail->data + tail->size);
+
+    // the only allocation in a side block resizes with it
+    void* bigger = arena_realloc(&a, big, LIBV_ARENA_MAX_BLOCK_SIZE,
+                                 2 * LIBV_ARENA_MAX_BLOCK_SIZE);
+    assert_ptr_nonnull(bigger);
+    assert_uint_eq(((unsigned char*)bigger)[LIBV_ARENA_MAX_BLOCK_SIZE - 1],
+                   0xAB);
+    assert_uint_eq(a.num_side, 1);
+    assert_uint_eq(a.stats.alloc_used, 200 + 2 * LIBV_ARENA_MAX_BLOCK_SIZE);
+
+    arena_reset(&a);
+    assert_uint_eq(a.num_side, 0);
+    assert_uint_eq(a.stats.num_blocks, 1);
+    assert_uint_eq(a.stats.alloc_size, tail->size);
+
+    arena_destroy(&a);
+}
+
+TEST(arena, side_blocks_rewind) {
+    arena a = arena_new();
+
+    arena_marker marker = arena_mark(&a);
+    assert_ptr_nonnull(arena_alloc(&a, LIBV_ARENA_SIDE_BLOCK_SIZE));
+    assert_ptr_nonnull(arena_alloc(&a, 100));
+    assert_uint_eq(a.num_side, 1);
+
+    arena_scope scope = arena_scope_begin(&a);
+    assert_ptr_nonnull(arena_alloc(&a, LIBV_ARENA_SIDE_BLOCK_SIZE));
+    assert_uint_eq(a.num_side, 2);
+    arena_scope_end(&scope);
+    assert_uint_eq(a.num_side, 1);
+
+    arena_rewind(&a, marker);
+    assert_uint_eq(a.num_side, 0);
+    assert_uint_eq(a.stats.alloc_used, 0);
+
+    arena_destroy(&a);
+}
+
+TEST(arena, wasted) {
+    arena a = arena_new();
+
+    // free space at the end of the tail is not waste
+    arena_alloc_aligned(&a, 8, 8);
+    assert_uint_eq(a.stats.alloc_wasted, 0);
+
+    // padding is
+    arena_alloc_aligned(&a, 1, 8);
+    arena_alloc_aligned(&a, 8, 64);
+    size_t padding = a.stats.alloc_wasted;
+    assert_true(padding > 0 && padding < 64);
+
+    // and so is the tail left behind by a new block
+    size_t left = a.tail->size - a.tail->used;
+    arena_alloc(&a, LIBV_ARENA_BLOCK_SIZE);
+    assert_true(a.stats.alloc_wasted >= padding + left);
+    assert_true(a.stats.alloc_used + a.stats.alloc_wasted <=
+                a.stats.alloc_size);
+
+    arena_destroy(&a);
+}
+
+VEC_DECLARE_DEFAULT(arena_int_vec, int);
+VMAP_DECLARE_DEFAULT_MAP(arena_int_map, int, int);
+
+static bool arena_owns(const arena* a, const void* ptr) {
+    for (const arena_block* b = a->head; b; b = b->next) {
+        if ((const unsigned char*)ptr >= b->data &&
+            (const unsigned char*)ptr < b->data + b->size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TEST(arena, allocator) {
+    arena a = arena_new();
+    libv_allocator allocator = arena_allocator(&a);
+
+    arena_int_vec v = arena_int_vec_new_in(&allocator);
+    for (int i = 0; i < 1000; ++i) {
+        assert_int_eq(arena_int_vec_push_back(&v, &i), LIBV_OK);
+    }
+    assert_true(arena_owns(&a, arena_int_vec_data(&v)));
+    assert_int_eq(*arena_int_vec_get_at(&v, 999), 999);
+
+    arena_int_map m = arena_int_map_new_in(0, &allocator);
+    for (int i = 0; i < 100; ++i) {
+        arena_int_map_entry e = {i, i * 2};
+        assert_true(arena_int_map_insert(&m, &e).inserted);
+    }
+    assert_true(arena_owns(&a, m.set.slots));
+    arena_int_map_iter it = arena_int_map_find(&m, &(int){42});
+    assert_int_eq(arena_int_map_iter_get(&it)->value, 84);
+
+    vstr_policy policy = vstr_policy_in(&allocator);
+    vstr s = vstr_from(&policy, "a string too long for the small buffer");
+    assert_true(vstr_is_large(&s));
+    assert_true(arena_owns(&a, vstr_data(&s)));
+    assert_int_eq(vstr_cat_string(&policy, &s, " and then some"), LIBV_OK);
+    assert_str_eq(vstr_data(&s),
+                  "a string too long for the small buffer and then some");
+
+    // nothing is freed one at a time, the arena drops everything at once
+    arena_reset(&a);
+    assert_uint_eq(a.stats.alloc_used, 0);
+
+    arena_destroy(&a);
+}
+
 VTEST_MAIN()
@@ -0,0 +1,161 @@
+#define LIBV_ARENA_IMPLEMENTATION
+#include "arena.h"
+#include "libv/vec/vec.h"
+#include "libv/vtest/vtest.h"
+#include <stdint.h>
+#include <string.h>
+
+TEST(arena_vm, contiguous) {
+    arena a = arena_new_vm(0);
+
+    char* first = arena_alloc_aligned(&a, 100, 8);
+    assert_ptr_nonnull(first);
+    memset(first, 0xAB, 100);
+
+    // allocations never leave the reservation, so they are back to back
+    char* prev = first;
+    for (int i = 0; i < 1000; ++i) {
+        char* ptr = arena_alloc_aligned(&a, 1000, 8);
+        assert_ptr_nonnull(ptr);
+        assert_true(ptr >= prev + 100);
+        assert_true(ptr <= prev + 1000 + 8);
+        memset(ptr, i & 0xFF, 1000);
+        prev = ptr;
+    }
+
+    assert_uint_eq(a.stats.num_blocks, 1);
+    assert_uint_eq(a.stats.alloc_used, 100 + 1000 * 1000);
+    // the only padding is after the first allocation
+    assert_uint_eq(a.stats.alloc_wasted, 4);
+
+    arena_destroy(&a);
+    assert_ptr_null(a.head);
+}
+
+TEST(arena_vm, alignment) {
+    arena a = arena_new_vm(0);
+
+    size_t aligns[] = {8, 16, 64, 4096};
+    for (size_t i = 0; i < array_size(aligns); ++i) {
+        arena_alloc(&a, 1);
+        void* ptr = arena_alloc_aligned(&a, 10, aligns[i]);
+        assert_ptr_nonnull(ptr);
+        assert_uint_eq((uintptr_t)ptr % aligns[i], 0);
+    }
+
+    assert_ptr_null(arena_alloc_aligned(&a, 10, 24));
+    assert_ptr_null(arena_alloc(&a, 0));
+
+    arena_destroy(&a);
+}
+
+TEST(arena_vm, realloc_grows_in_place) {
+    arena a = arena_new_vm(0);
+
+    char* ptr = arena_alloc(&a, 16);
+    memset(ptr, 'x', 16);
+
+    // well past the first commit, the last allocation still grows in place
+    size_t size = 16;
+    for (size_t new_size = 64; new_size <= 8 * 1024 * 1024; new_size *= 4) {
+        char* grown = arena_realloc(&a, ptr, size, new_size);
+        assert_true(grown == ptr);
+        memset(grown + size, 'y', new_size - size);
+        size = new_size;
+    }
+    assert_int_eq(ptr[0], 'x');
+    assert_int_eq(ptr[size - 1], 'y');
+    assert_uint_eq(a.stats.alloc_used, size);
+
+    arena_destroy(&a);
+}
+
+TEST(arena_vm, reservation_exhausted) {
+    arena a = arena_new_vm(1024 * 1024);
+
+    assert_ptr_nonnull(arena_alloc(&a, 1000 * 1000));
+    assert_ptr_null(arena_alloc(&a, 100 * 1000));
+    assert_uint_eq(a.stats.alloc_size,
+                   1024 * 1024 - offsetof(arena_block, data));
+
+    arena_destroy(&a);
+}
+
+TEST(arena_vm, reset_decommits) {
+    arena a = arena_new_vm(0);
+
+    char* ptr = arena_alloc(&a, 16 * 1024 * 1024);
+    memset(ptr, 1, 16 * 1024 * 1024);
+    assert_true(a.stats.alloc_size >= 16 * 1024 * 1024);
+
+    arena_reset(&a);
+    assert_uint_eq(a.stats.alloc_size,
+                   LIBV_ARENA_VM_RETAIN - offsetof(arena_block, data));
+    assert_uint_eq(a.stats.alloc_used, 0);
+    assert_uint_eq(a.stats.alloc_wasted, 0);
+
+    // the range is reused from the start and recommitted as needed
+    char* again = arena_alloc(&a, 4 * 1024 * 1024);
+    assert_true(again == ptr);
+    memset(again, 2, 4 * 1024 * 1024);
+
+    arena_destroy(&a);
+}
+
+TEST(arena_vm, reset_trim_and_reuse) {
+    arena a = arena_new_vm(0);
+
+    char* ptr = arena_alloc(&a, 4 * 1024 * 1024);
+    memset(ptr, 1, 4 * 1024 * 1024);
+
+    // only the page holding the block header survives a full trim
+    arena_reset_trim(&a, 0);
+    assert_uint_eq(a.stats.num_blocks, 1);
+    assert_uint_eq(a.stats.alloc_size,
+                   vmem_page_size() - offsetof(arena_block, data));
+    assert_true(arena_alloc(&a, 100) == ptr);
+
+    // a destroyed arena keeps its mode and reserves again on first use
+    arena_destroy(&a);
+    assert_uint_eq(a.stats.alloc_size, 0);
+    assert_ptr_nonnull(arena_alloc(&a, 100));
+    assert_uint_eq(a.stats.num_blocks, 1);
+    assert_true(a.reserved != 0);
+
+    arena_destroy(&a);
+}
+
+TEST(arena_vm, scope) {
+    arena a = arena_new_vm(0);
+
+    arena_alloc(&a, 100);
+    size_t used = a.stats.alloc_used;
+
+    arena_scope scope = arena_scope_begin(&a);
+    void* tmp = arena_alloc(&a, 5000);
+    arena_scope_end(&scope);
+    assert_uint_eq(a.stats.alloc_used, used);
+
+    assert_true(arena_alloc(&a, 5000) == tmp);
+
+    arena_destroy(&a);
+}
+
+VEC_DECLARE_DEFAULT(vm_int_vec, int);
+
+TEST(arena_vm, allocator) {
+    arena a = arena_new_vm(0);
+    libv_allocator allocator = arena_allocator(&a);
+
+    vm_int_vec v = vm_int_vec_new_in(&allocator);
+    for (int i = 0; i < 100000; ++i) {
+        assert_int_eq(vm_int_vec_push_back(&v, &i), LIBV_OK);
+    }
+    // the vec is the only allocation, so every grow happened in place
+    assert_true((void*)vm_int_vec_data(&v) == a.head->data);
+    assert_int_eq(*vm_int_vec_get_at(&v, 99999), 99999);
+
+    arena_destroy(&a);
+}
+
+VTEST_MAIN()
@@ -37,8 +37,14 @@
 
 #define __LIBV_BASE_H__
 
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif // _MSC_VER
 
 #define LIBV_OK 0
 #define LIBV_ERR -1
@@ -162,6 +168,35 @@ static inline void libv_set_debug_mode(int mode) { libv_debug_mode = mode; }
 
 #define array_size(arr) sizeof arr / sizeof arr[0]
 
+#ifndef LIBV_CACHE_LINE_SIZE
+#define LIBV_CACHE_LINE_SIZE 64
+#endif // LIBV_CACHE_LINE_SIZE
+
+// malloc only guarantees the alignment of max_align_t. anything stricter has
+// to go through libv_aligned_alloc and be released with libv_aligned_free.
+static inline int libv_is_over_aligned(size_t align) {
+    return align > _Alignof(max_align_t);
+}
+
+// align must be a power of two
+static inline void* libv_aligned_alloc(size_t size, size_t align) {
+#if defined(_MSC_VER)
+    return _aligned_malloc(size, align);
+#else
+    // aligned_alloc wants a non zero multiple of the alignment
+    size = size == 0 ? align : (size + align - 1) & ~(align - 1);
+    return aligned_alloc(align, size);
+#endif // _MSC_VER
+}
+
+static inline void libv_aligned_free(void* ptr) {
+#if defined(_MSC_VER)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif // _MSC_VER
+}
+
 typedef struct {
     void* (*alloc)(size_t size, size_t align);
     void* (*calloc)(size_t nmem, size_t size);
@@ -171,22 +206,48 @@ typedef struct {
 
 typedef struct {
     void* (*alloc)(size_t size, size_t align);
+    // optional, returns zeroed memory so callers can skip clearing it
+    void* (*calloc)(size_t nmem, size_t size);
     void (*free)(void* ptr, size_t size, size_t align);
 } libv_basic_alloc_policy;
 
 static inline void* libv_default_alloc(size_t size, size_t align) {
-    LIBV_UNUSED(align);
-    void* ptr = malloc(size);
+    void* ptr = libv_is_over_aligned(align) ? libv_aligned_alloc(size, align)
+                                            : malloc(size);
     if (!ptr) {
         libv_panic("failed to allocate %zu bytes\n", size);
     }
     return ptr;
 }
 
+// only aligned for max_align_t, callers with stricter alignment use alloc
+static inline void* libv_default_calloc(size_t nmem, size_t size) {
+    void* ptr = calloc(nmem, size);
+    if (!ptr) {
+        libv_panic("failed to allocate %zu bytes\n", nmem * size);
+    }
+    return ptr;
+}
+
 static inline void* libv_default_realloc(void* ptr, size_t old_size,
                                          size_t new_size, size_t align) {
-    LIBV_UNUSED(old_size);
-    LIBV_UNUSED(align);
+    if (libv_is_over_aligned(align)) {
+        // realloc may move the block to a less aligned address, so over
+        // aligned blocks are always moved by hand
+        if (new_size == 0) {
+            libv_aligned_free(ptr);
+            return NULL;
+        }
+        void* new_ptr = libv_aligned_alloc(new_size, align);
+        if (!new_ptr) {
+            libv_panic("failed to re-allocate %p %zu bytes\n", ptr, new_size);
+        }
+        if (ptr) {
+            memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+            libv_aligned_free(ptr);
+        }
+        return new_ptr;
+    }
     void* new_ptr = realloc(ptr, new_size);
     if (!new_ptr) {
         libv_panic("failed to re-allocate %p %zu bytes\n", ptr, new_size);
@@ -196,11 +257,52 @@ static inline void* libv_default_realloc(void* ptr, size_t old_size,
 
 static inline void libv_default_free(void* ptr, size_t size, size_t align) {
     LIBV_UNUSED(size);
-    LIBV_UNUSED(align);
+    if (libv_is_over_aligned(align)) {
+        libv_aligned_free(ptr);
+        return;
+    }
     free(ptr);
     ptr = NULL;
 }
 
+// a stateful allocator. ctx is handed back to every call, so unlike the
+// policies above an allocator can point at a specific arena or pool.
+// containers take a pointer to one, which must outlive the container.
+typedef struct {
+    void* ctx;
+    void* (*alloc)(void* ctx, size_t size, size_t align);
+    void* (*realloc)(void* ctx, void* ptr, size_t old_size, size_t new_size,
+                     size_t align);
+    void (*free)(void* ctx, void* ptr, size_t size, size_t align);
+} libv_allocator;
+
+static inline void* libv_malloc_allocator_alloc(void* ctx, size_t size,
+                                                size_t align) {
+    LIBV_UNUSED(ctx);
+    return libv_default_alloc(size, align);
+}
+
+static inline void* libv_malloc_allocator_realloc(void* ctx, void* ptr,
+                                                  size_t old_size,
+                                                  size_t new_size,
+                                                  size_t align) {
+    LIBV_UNUSED(ctx);
+    return libv_default_realloc(ptr, old_size, new_size, align);
+}
+
+static inline void libv_malloc_allocator_free(void* ctx, void* ptr,
+                                              size_t size, size_t align) {
+    LIBV_UNUSED(ctx);
+    libv_default_free(ptr, size, align);
+}
+
+static const libv_allocator libv_malloc_allocator = {
+    .ctx = NULL,
+    .alloc = libv_malloc_allocator_alloc,
+    .realloc = libv_malloc_allocator_realloc,
+    .free = libv_malloc_allocator_free,
+};
+
 LIBV_END
 
 #endif // __LIBV_BASE_H__
@@ -0,0 +1,376 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2026, vincer2040
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+// heap
+// a general purpose size class allocator. small allocations are rounded up
+// to one of LIBV_HEAP_NUM_CLASSES sizes and served from per thread free
+// lists. the lists refill from, and overflow back to, central lists in
+// batches, so the shared lock is taken once per batch rather than once per
+// call. memory for new objects is carved out of a central arena. anything
+// larger than LIBV_HEAP_MAX_SMALL goes to the system allocator.
+//
+// sizes are passed to free, so the heap never has to look up which class a
+// pointer came from and objects carry no header.
+//
+// there is one heap per process. exactly one translation unit must define
+// LIBV_HEAP_IMPLEMENTATION before including heap.h, that is where the central
+// heap and the thread caches are defined, every other translation unit only
+// declares them. the central heap carves from an arena, so the arena pool
+// needs LIBV_ARENA_IMPLEMENTATION defined somewhere too.
+//
+// an object freed on another thread joins the freeing thread's cache, not
+// the allocating thread's, and goes back to the central lists once that
+// cache holds more than two batches of its class. a thread's cache is handed
+// back to the central lists when the thread exits, libv_heap_thread_release
+// does the same earlier.
+
+#ifndef __LIBV_HEAP_H__
+
+#define __LIBV_HEAP_H__
+
+#include "libv/arena/arena.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+LIBV_BEGIN
+
+#define LIBV_HEAP_NUM_CLASSES 40
+#define LIBV_HEAP_MAX_SMALL (32 * 1024)
+
+// the bytes moved between a thread cache and the central lists at a time
+#ifndef LIBV_HEAP_BATCH_BYTES
+#define LIBV_HEAP_BATCH_BYTES (64 * 1024)
+#endif // LIBV_HEAP_BATCH_BYTES
+
+// 16 byte steps up to 128, then four steps per power of two
+static const size_t libv_heap_class_sizes[LIBV_HEAP_NUM_CLASSES] = {
+    16,    32,    48,    64,    80,    96,    112,   128,   160,   192,
+    224,   256,   320,   384,   448,   512,   640,   768,   896,   1024,
+    1280,  1536,  1792,  2048,  2560,  3072,  3584,  4096,  5120,  6144,
+    7168,  8192,  10240, 12288, 14336, 16384, 20480, 24576, 28672, 32768,
+};
+
+typedef struct libv_heap_object libv_heap_object;
+
+struct libv_heap_object {
+    libv_heap_object* next;
+};
+
+typedef struct {
+    libv_heap_object* lists[LIBV_HEAP_NUM_CLASSES];
+    size_t counts[LIBV_HEAP_NUM_CLASSES];
+    bool registered; // the thread exit destructor is armed
+} libv_heap_cache;
+
+typedef struct {
+    atomic_flag lock;
+    arena arena; // new objects are carved out of its blocks
+    libv_heap_object* lists[LIBV_HEAP_NUM_CLASSES];
+    pthread_once_t once;
+    pthread_key_t key; // flushes a thread's cache when the thread exits
+    bool has_key;      // false if the key could not be created
+} libv_heap_central;
+
+#ifdef LIBV_HEAP_IMPLEMENTATION
+_Thread_local libv_heap_cache libv_heap_thread_cache;
+libv_heap_central libv_heap_central_heap = {
+    .lock = ATOMIC_FLAG_INIT,
+    .once = PTHREAD_ONCE_INIT,
+};
+#else
+extern _Thread_local libv_heap_cache libv_heap_thread_cache;
+extern libv_heap_central libv_heap_central_heap;
+#endif // LIBV_HEAP_IMPLEMENTATION
+
+// the smallest class holding size bytes, size must be at most
+// LIBV_HEAP_MAX_SMALL
+static inline size_t libv_heap_size_class(size_t size) {
+    if (size <= 128) {
+        return size == 0 ? 0 : (size - 1) >> 4;
+    }
+    size_t k = 63 - vmap_leading_zeros64(size - 1);
+    return 8 + (k - 7) * 4 + (((size - 1) >> (k - 2)) & 3);
+}
+
+// objects of a class are laid out at multiples of the class size from an
+// aligned chunk, so they are aligned to its lowest set bit
+static inline size_t libv_heap_class_align(size_t cls) {
+    size_t size = libv_heap_class_sizes[cls];
+    size_t align = size & (~size + 1);
+    return align < 4096 ? align : 4096;
+}
+
+// the class for an allocation, LIBV_HEAP_NUM_CLASSES if it is too large or
+// too strictly aligned for one. the result only depends on size and align,
+// which is what lets free find the class again.
+static inline size_t libv_heap_class_of(size_t size, size_t align) {
+    if (size > LIBV_HEAP_MAX_SMALL) {
+        return LIBV_HEAP_NUM_CLASSES;
+    }
+    size_t cls = libv_heap_size_class(size);
+    while (cls < LIBV_HEAP_NUM_CLASSES && libv_heap_class_align(cls) < align) {
+        ++cls;
+    }
+    return cls;
+}
+
+static inline size_t libv_heap_batch(size_t cls) {
+    size_t batch = LIBV_HEAP_BATCH_BYTES / libv_heap_class_sizes[cls];
+    return batch < 2 ? 2 : batch > 64 ? 64 : batch;
+}
+
+static inline void libv_heap_lock(void) {
+    while (atomic_flag_test_and_set_explicit(&libv_heap_central_heap.lock,
+                                             memory_order_acquire)) {
+    }
+}
+
+static inline void libv_heap_unlock(void) {
+    atomic_flag_clear_explicit(&libv_heap_central_heap.lock,
+                               memory_order_release);
+}
+
+// hands n objects from cache's list of cls back to the central list
+static inline void libv_heap_flush(libv_heap_cache* cache, size_t cls,
+                                   size_t n) {
+    libv_heap_object* first = cache->lists[cls];
+    if (first == NULL || n == 0) {
+        return;
+    }
+    libv_heap_object* last = first;
+    size_t moved = 1;
+    for (; moved < n && last->next; ++moved) {
+        last = last->next;
+    }
+    cache->lists[cls] = last->next;
+    cache->counts[cls] -= moved;
+
+    libv_heap_lock();
+    last->next = libv_heap_central_heap.lists[cls];
+    libv_heap_central_heap.lists[cls] = first;
+    libv_heap_unlock();
+}
+
+static inline void libv_heap_cache_flush(libv_heap_cache* cache) {
+    for (size_t cls = 0; cls < LIBV_HEAP_NUM_CLASSES; ++cls) {
+        libv_heap_flush(cache, cls, cache->counts[cls]);
+    }
+}
+
+// objects cached by later destructors arm it again, pthreads runs them again
+static inline void libv_heap_cache_exit(void* cache) {
+    ((libv_heap_cache*)cache)->registered = false;
+    libv_heap_cache_flush(cache);
+}
+
+static inline void libv_heap_create_key(void) {
+    libv_heap_central_heap.has_key =
+        pthread_key_create(&libv_heap_central_heap.key,
+                           libv_heap_cache_exit) == 0;
+}
+
+// arms the destructor that flushes the cache when the thread exits
+LIBV_INLINE_NEVER static bool libv_heap_register(libv_heap_cache* cache) {
+    pthread_once(&libv_heap_central_heap.once, libv_heap_create_key);
+    cache->registered =
+        libv_heap_central_heap.has_key &&
+        pthread_setspecific(libv_heap_central_heap.key, cache) == 0;
+    return cache->registered;
+}
+
+// moves a batch from the central list of cls to the calling thread's cache,
+// carving new objects when the central list is empty
+LIBV_INLINE_NEVER static void libv_heap_refill(size_t cls) {
+    libv_heap_cache* cache = &libv_heap_thread_cache;
+    // a thread that cannot flush its cache on exit only takes what it needs
+    size_t batch = cache->registered || libv_heap_register(cache)
+                       ? libv_heap_batch(cls)
+                       : 1;
+    size_t size = libv_heap_class_sizes[cls];
+
+    libv_heap_lock();
+    libv_heap_object* list = libv_heap_central_heap.lists[cls];
+    size_t n = 0;
+    if (list) {
+        libv_heap_object* last = list;
+        for (n = 1; n < batch && last->next; ++n) {
+            last = last->next;
+        }
+        libv_heap_central_heap.lists[cls] = last->next;
+        last->next = NULL;
+    } else {
+        unsigned char* chunk =
+            arena_alloc_aligned(&libv_heap_central_heap.arena, batch * size,
+                                libv_heap_class_align(cls));
+        if (chunk) {
+            for (n = batch; n > 0; --n) {
+                libv_heap_object* object =
+                    (libv_heap_object*)(chunk + (n - 1) * size);
+                object->next = list;
+                list = object;
+            }
+            n = batch;
+        }
+    }
+    libv_heap_unlock();
+
+    if (list == NULL) {
+        libv_panic("failed to allocate %zu bytes\n", size);
+    }
+    cache->lists[cls] = list;
+    cache->counts[cls] = n;
+}
+
+LIBV_INLINE_ALWAYS static inline void* libv_heap_alloc(size_t size,
+                                                       size_t align) {
+    size_t cls = libv_heap_class_of(size, align);
+    if (LIBV_UNLIKELY(cls == LIBV_HEAP_NUM_CLASSES)) {
+        return libv_default_alloc(size, align);
+    }
+    libv_heap_cache* cache = &libv_heap_thread_cache;
+    if (LIBV_UNLIKELY(cache->lists[cls] == NULL)) {
+        libv_heap_refill(cls);
+    }
+    libv_heap_object* object = cache->lists[cls];
+    cache->lists[cls] = object->next;
+    --cache->counts[cls];
+    return object;
+}
+
+// size and align must be the ones the object was allocated with
+static inline void libv_heap_free(void* ptr, size_t size, size_t align) {
+    if (ptr == NULL) {
+        return;
+    }
+    size_t cls = libv_heap_class_of(size, align);
+    if (LIBV_UNLIKELY(cls == LIBV_HEAP_NUM_CLASSES)) {
+        libv_default_free(ptr, size, align);
+        return;
+    }
+    libv_heap_cache* cache = &libv_heap_thread_cache;
+    libv_heap_object* object = ptr;
+    object->next = cache->lists[cls];
+    cache->lists[cls] = object;
+    ++cache->counts[cls];
+    if (LIBV_UNLIKELY(!cache->registered) && !libv_heap_register(cache)) {
+        libv_heap_flush(cache, cls, cache->counts[cls]);
+        return;
+    }
+    size_t batch = libv_heap_batch(cls);
+    if (LIBV_UNLIKELY(cache->counts[cls] > 2 * batch)) {
+        libv_heap_flush(cache, cls, batch);
+    }
+}
+
+static inline void* libv_heap_calloc(size_t nmem, size_t size) {
+    if (size != 0 && nmem > SIZE_MAX / size) {
+        libv_panic("failed to allocate %zu * %zu bytes\n", nmem, size);
+    }
+    void* ptr = libv_heap_alloc(nmem * size, _Alignof(max_align_t));
+    memset(ptr, 0, nmem * size);
+    return ptr;
+}
+
+static inline void* libv_heap_realloc(void* ptr, size_t old_size,
+                                      size_t new_size, size_t align) {
+    if (ptr == NULL) {
+        return libv_heap_alloc(new_size, align);
+    }
+    if (new_size == 0) {
+        libv_heap_free(ptr, old_size, align);
+        return NULL;
+    }
+    size_t old_cls = libv_heap_class_of(old_size, align);
+    size_t new_cls = libv_heap_class_of(new_size, align);
+    if (old_cls == new_cls) {
+        if (old_cls != LIBV_HEAP_NUM_CLASSES) {
+            return ptr;
+        }
+        return libv_default_realloc(ptr, old_size, new_size, align);
+    }
+    void* new_ptr = libv_heap_alloc(new_size, align);
+    memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    libv_heap_free(ptr, old_size, align);
+    return new_ptr;
+}
+
+// returns the calling thread's cached objects to the central lists now
+// instead of when the thread exits
+static inline void libv_heap_thread_release(void) {
+    libv_heap_cache_flush(&libv_heap_thread_cache);
+}
+
+static const libv_alloc_policy libv_heap_alloc_policy = {
+    .alloc = libv_heap_alloc,
+    .calloc = libv_heap_calloc,
+    .realloc = libv_heap_realloc,
+    .free = libv_heap_free,
+};
+
+static const libv_basic_alloc_policy libv_heap_basic_alloc_policy = {
+    .alloc = libv_heap_alloc,
+    .calloc = libv_heap_calloc,
+    .free = libv_heap_free,
+};
+
+static inline void* libv_heap_allocator_alloc(void* ctx, size_t size,
+                                              size_t align) {
+    LIBV_UNUSED(ctx);
+    return libv_heap_alloc(size, align);
+}
+
+static inline void* libv_heap_allocator_realloc(void* ctx, void* ptr,
+                                                size_t old_size,
+                                                size_t new_size, size_t align) {
+    LIBV_UNUSED(ctx);
+    return libv_heap_realloc(ptr, old_size, new_size, align);
+}
+
+static inline void libv_heap_allocator_free(void* ctx, void* ptr, size_t size,
+                                            size_t align) {
+    LIBV_UNUSED(ctx);
+    libv_heap_free(ptr, size, align);
+}
+
+static const libv_allocator libv_heap_allocator = {
+    .ctx = NULL,
+    .alloc = libv_heap_allocator_alloc,
+    .realloc = libv_heap_allocator_realloc,
+    .free = libv_heap_allocator_free,
+};
+
+LIBV_END
+
+#endif // __LIBV_HEAP_H__
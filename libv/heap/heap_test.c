@@ -0,0 +1,200 @@
+#define LIBV_ARENA_IMPLEMENTATION
+#define LIBV_HEAP_IMPLEMENTATION
+#include "heap.h"
+#include "libv/vec/vec.h"
+#include "libv/vtest/vtest.h"
+#include <pthread.h>
+#include <stdint.h>
+
+TEST(heap, size_classes) {
+    for (size_t size = 1; size <= LIBV_HEAP_MAX_SMALL; ++size) {
+        size_t cls = libv_heap_size_class(size);
+        assert_true(cls < LIBV_HEAP_NUM_CLASSES);
+        assert_true(libv_heap_class_sizes[cls] >= size);
+        if (cls > 0) {
+            assert_true(libv_heap_class_sizes[cls - 1] < size);
+        }
+    }
+    assert_uint_eq(libv_heap_class_of(LIBV_HEAP_MAX_SMALL + 1, 8),
+                   LIBV_HEAP_NUM_CLASSES);
+}
+
+TEST(heap, alloc_free) {
+    unsigned char* a = libv_heap_alloc(100, 8);
+    memset(a, 0xaa, 100);
+    libv_heap_free(a, 100, 8);
+
+    // the most recently freed object of a class comes back first
+    unsigned char* b = libv_heap_alloc(112, 8);
+    assert_true(a == b);
+    libv_heap_free(b, 112, 8);
+
+    int* zeroed = libv_heap_calloc(10, sizeof(int));
+    for (int i = 0; i < 10; ++i) {
+        assert_int_eq(zeroed[i], 0);
+    }
+    libv_heap_free(zeroed, 10 * sizeof(int), _Alignof(max_align_t));
+}
+
+TEST(heap, alignment) {
+    size_t aligns[] = {8, 16, 64, 256, 4096};
+    for (size_t i = 0; i < array_size(aligns); ++i) {
+        void* ptrs[32];
+        for (size_t j = 0; j < array_size(ptrs); ++j) {
+            ptrs[j] = libv_heap_alloc(24, aligns[i]);
+            assert_uint_eq((uintptr_t)ptrs[j] % aligns[i], 0);
+        }
+        for (size_t j = 0; j < array_size(ptrs); ++j) {
+            libv_heap_free(ptrs[j], 24, aligns[i]);
+        }
+    }
+
+    // too large for a class
+    void* big = libv_heap_alloc(LIBV_HEAP_MAX_SMALL + 1, 8192);
+    assert_uint_eq((uintptr_t)big % 8192, 0);
+    libv_heap_free(big, LIBV_HEAP_MAX_SMALL + 1, 8192);
+}
+
+TEST(heap, realloc) {
+    unsigned char* a = libv_heap_alloc(65, 8);
+    memset(a, 1, 65);
+
+    // 65 and 80 share a class
+    assert_true(libv_heap_realloc(a, 65, 80, 8) == a);
+
+    unsigned char* b = libv_heap_realloc(a, 80, 1000, 8);
+    for (int i = 0; i < 65; ++i) {
+        assert_uint_eq(b[i], 1);
+    }
+
+    unsigned char* c = libv_heap_realloc(b, 1000, 100000, 8);
+    assert_uint_eq(c[64], 1);
+    c[99999] = 2;
+    c = libv_heap_realloc(c, 100000, 200000, 8);
+    assert_uint_eq(c[99999], 2);
+    assert_ptr_null(libv_heap_realloc(c, 200000, 0, 8));
+}
+
+#define NUM_THREADS 4
+#define NUM_OBJECTS 2000
+
+static uint64_t* shared[NUM_THREADS][NUM_OBJECTS];
+
+// each thread allocates a set of objects, then frees the set of its
+// neighbour, so every free is a remote one
+static void* remote_worker(void* arg) {
+    size_t id = (size_t)(uintptr_t)arg;
+    for (size_t i = 0; i < NUM_OBJECTS; ++i) {
+        shared[id][i] = libv_heap_alloc(sizeof(uint64_t), 8);
+        *shared[id][i] = (uintptr_t)shared[id][i];
+    }
+    libv_heap_thread_release();
+    return NULL;
+}
+
+static void* remote_free_worker(void* arg) {
+    size_t id = ((size_t)(uintptr_t)arg + 1) % NUM_THREADS;
+    for (size_t i = 0; i < NUM_OBJECTS; ++i) {
+        if (*shared[id][i] != (uintptr_t)shared[id][i]) {
+            return (void*)1;
+        }
+        libv_heap_free(shared[id][i], sizeof(uint64_t), 8);
+    }
+    libv_heap_thread_release();
+    return NULL;
+}
+
+TEST(heap, remote_free) {
+    pthread_t threads[NUM_THREADS];
+    for (size_t i = 0; i < NUM_THREADS; ++i) {
+        pthread_create(&threads[i], NULL, remote_worker, (void*)(uintptr_t)i);
+    }
+    for (size_t i = 0; i < NUM_THREADS; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    for (size_t i = 0; i < NUM_THREADS; ++i) {
+        pthread_create(&threads[i], NULL, remote_free_worker,
+                       (void*)(uintptr_t)i);
+    }
+    for (size_t i = 0; i < NUM_THREADS; ++i) {
+        void* res;
+        pthread_join(threads[i], &res);
+        assert_ptr_null(res);
+    }
+
+    // the released objects are handed out again before new ones are carved
+    size_t before = libv_heap_central_heap.arena.stats.alloc_size;
+    void* ptrs[NUM_OBJECTS];
+    for (size_t i = 0; i < NUM_OBJECTS; ++i) {
+        ptrs[i] = libv_heap_alloc(sizeof(uint64_t), 8);
+    }
+    assert_uint_eq(libv_heap_central_heap.arena.stats.alloc_size,
+                   before);
+    for (size_t i = 0; i < NUM_OBJECTS; ++i) {
+        libv_heap_free(ptrs[i], sizeof(uint64_t), 8);
+    }
+}
+
+static inline void int_copy(void* dst, const void* src) {
+    memcpy(dst, src, sizeof(int));
+}
+
+static inline bool int_eq(const void* a, const void* b) {
+    return memcmp(a, b, sizeof(int)) == 0;
+}
+
+static const vec_object_policy int_object_policy = {
+    sizeof(int), _Alignof(int), int_copy, int_eq, NULL,
+};
+
+static const vec_policy heap_vec_policy = {
+    &libv_heap_alloc_policy,
+    &int_object_policy,
+};
+
+VEC_DECLARE(heap_vec, heap_vec_policy, int);
+
+TEST(heap, alloc_policy) {
+    heap_vec v = heap_vec_new();
+    for (int i = 0; i < 10000; ++i) {
+        assert_int_eq(heap_vec_push_back(&v, &i), LIBV_OK);
+    }
+    for (int i = 0; i < 10000; ++i) {
+        assert_int_eq(*heap_vec_get_at(&v, i), i);
+    }
+    heap_vec_free(&v);
+}
+
+static size_t central_count(size_t cls) {
+    size_t n = 0;
+    for (libv_heap_object* object = libv_heap_central_heap.lists[cls]; object;
+         object = object->next) {
+        ++n;
+    }
+    return n;
+}
+
+static void* exit_free_worker(void* arg) {
+    void** ptrs = arg;
+    libv_heap_free(ptrs[0], 20000, 8);
+    libv_heap_free(ptrs[1], 20000, 8);
+    // exits without libv_heap_thread_release
+    return NULL;
+}
+
+TEST(heap, thread_exit) {
+    size_t cls = libv_heap_class_of(20000, 8);
+    void* ptrs[2] = {
+        libv_heap_alloc(20000, 8),
+        libv_heap_alloc(20000, 8),
+    };
+    size_t before = central_count(cls);
+
+    // the remote frees stay in the worker's cache until it exits
+    pthread_t thread;
+    assert_int_eq(pthread_create(&thread, NULL, exit_free_worker, ptrs), 0);
+    assert_int_eq(pthread_join(thread, NULL), 0);
+    assert_uint_eq(central_count(cls), before + 2);
+}
+
+VTEST_MAIN()
@@ -0,0 +1,386 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2026, vincer2040
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+// vdeque
+// a double ended queue on a power of two ring buffer. push and pop at either
+// end are amortized O(1) and never move the other elements. elements use the
+// same vec_policy as vec.
+
+#ifndef __LIBV_VDEQUE_H__
+
+#define __LIBV_VDEQUE_H__
+
+#include "libv/vec/vec.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+LIBV_BEGIN
+
+typedef struct {
+    char* data;
+    size_t head; // index of the front element in data
+    size_t size;
+    size_t capacity; // zero or a power of two
+    // when set, storage comes from here instead of the policy's alloc
+    const libv_allocator* allocator;
+} vdeque_raw;
+
+// the elements in order as at most two contiguous runs, second is empty
+// unless the elements wrap around the end of the buffer
+typedef struct {
+    const void* first;
+    size_t first_size;
+    const void* second;
+    size_t second_size;
+} vdeque_raw_slices;
+
+// init / destroy
+
+static inline vdeque_raw vdeque_raw_new(void) {
+    vdeque_raw self = {0};
+    return self;
+}
+
+static inline vdeque_raw vdeque_raw_new_in(const libv_allocator* allocator) {
+    vdeque_raw self = {0};
+    self.allocator = allocator;
+    return self;
+}
+
+static inline char* vdeque_raw_slot(const vec_policy* policy,
+                                    const vdeque_raw* self, size_t index) {
+    return self->data +
+           (((self->head + index) & (self->capacity - 1)) * policy->obj->size);
+}
+
+static inline void vdeque_raw_clear(const vec_policy* policy,
+                                    vdeque_raw* self) {
+    if (policy->obj->dtor) {
+        for (size_t i = 0; i < self->size; ++i) {
+            policy->obj->dtor(vdeque_raw_slot(policy, self, i));
+        }
+    }
+    self->head = 0;
+    self->size = 0;
+}
+
+static inline void vdeque_raw_free(const vec_policy* policy,
+                                   vdeque_raw* self) {
+    vdeque_raw_clear(policy, self);
+    if (self->allocator) {
+        self->allocator->free(self->allocator->ctx, self->data,
+                              self->capacity * policy->obj->size,
+                              policy->obj->align);
+    } else {
+        policy->alloc->free(self->data, self->capacity * policy->obj->size,
+                            policy->obj->align);
+    }
+    self->data = NULL;
+    self->capacity = 0;
+}
+
+// capacity
+
+static inline bool vdeque_raw_empty(const vdeque_raw* self) {
+    return self->size == 0;
+}
+
+static inline size_t vdeque_raw_size(const vdeque_raw* self) {
+    return self->size;
+}
+
+static inline size_t vdeque_raw_capacity(const vdeque_raw* self) {
+    return self->capacity;
+}
+
+// grows the buffer to new_capacity, a power of two. realloc keeps the bytes
+// in place, so only the run that wrapped around to the start of the old
+// buffer has to move to just past its old end.
+LIBV_INLINE_NEVER static int vdeque_raw_grow(const vec_policy* policy,
+                                             vdeque_raw* self,
+                                             size_t new_capacity) {
+    size_t obj_size = policy->obj->size;
+    size_t old_capacity = self->capacity;
+    size_t old_size = old_capacity * obj_size;
+    size_t new_size = new_capacity * obj_size;
+    char* tmp;
+    if (self->allocator) {
+        tmp = self->allocator->realloc(self->allocator->ctx, self->data,
+                                       old_size, new_size, policy->obj->align);
+    } else {
+        tmp = policy->alloc->realloc(self->data, old_size, new_size,
+                                     policy->obj->align);
+    }
+    if (!tmp) {
+        return LIBV_ERR;
+    }
+    self->data = tmp;
+    self->capacity = new_capacity;
+    if (self->head + self->size > old_capacity) {
+        size_t wrapped = self->head + self->size - old_capacity;
+        memcpy(self->data + old_size, self->data, wrapped * obj_size);
+    }
+    return LIBV_OK;
+}
+
+static inline int vdeque_raw_reserve(const vec_policy* policy,
+                                     vdeque_raw* self, size_t capacity) {
+    if (self->capacity >= capacity) {
+        return LIBV_OK;
+    }
+    size_t new_capacity = self->capacity == 0 ? 8 : self->capacity;
+    while (new_capacity < capacity) {
+        new_capacity <<= 1;
+    }
+    return vdeque_raw_grow(policy, self, new_capacity);
+}
+
+static inline int vdeque_raw_maybe_grow(const vec_policy* policy,
+                                        vdeque_raw* self) {
+    if (LIBV_LIKELY(self->size < self->capacity)) {
+        return LIBV_OK;
+    }
+    return vdeque_raw_grow(policy, self,
+                           self->capacity == 0 ? 8 : self->capacity << 1);
+}
+
+// access
+
+static inline const void* vdeque_raw_get_at_unchecked(const vec_policy* policy,
+                                                      const vdeque_raw* self,
+                                                      size_t index) {
+    return vdeque_raw_slot(policy, self, index);
+}
+
+static inline const void* vdeque_raw_get_at(const vec_policy* policy,
+                                            const vdeque_raw* self,
+                                            size_t index) {
+    if (index >= self->size) {
+        return NULL;
+    }
+    return vdeque_raw_slot(policy, self, index);
+}
+
+static inline const void* vdeque_raw_front(const vec_policy* policy,
+                                           const vdeque_raw* self) {
+    return vdeque_raw_get_at(policy, self, 0);
+}
+
+static inline const void* vdeque_raw_back(const vec_policy* policy,
+                                          const vdeque_raw* self) {
+    if (self->size == 0) {
+        return NULL;
+    }
+    return vdeque_raw_slot(policy, self, self->size - 1);
+}
+
+static inline vdeque_raw_slices vdeque_raw_as_slices(const vec_policy* policy,
+                                                     const vdeque_raw* self) {
+    vdeque_raw_slices slices = {0};
+    if (self->size == 0) {
+        return slices;
+    }
+    size_t to_end = self->capacity - self->head;
+    slices.first = self->data + (self->head * policy->obj->size);
+    if (self->size <= to_end) {
+        slices.first_size = self->size;
+        return slices;
+    }
+    slices.first_size = to_end;
+    slices.second = self->data;
+    slices.second_size = self->size - to_end;
+    return slices;
+}
+
+// modification
+
+static inline int vdeque_raw_push_back(const vec_policy* policy,
+                                       vdeque_raw* self, const void* value) {
+    if (vdeque_raw_maybe_grow(policy, self) == LIBV_ERR) {
+        return LIBV_ERR;
+    }
+    policy->obj->copy(vdeque_raw_slot(policy, self, self->size), value);
+    self->size++;
+    return LIBV_OK;
+}
+
+static inline int vdeque_raw_push_front(const vec_policy* policy,
+                                        vdeque_raw* self, const void* value) {
+    if (vdeque_raw_maybe_grow(policy, self) == LIBV_ERR) {
+        return LIBV_ERR;
+    }
+    self->head = (self->head - 1) & (self->capacity - 1);
+    policy->obj->copy(self->data + (self->head * policy->obj->size), value);
+    self->size++;
+    return LIBV_OK;
+}
+
+static inline int vdeque_raw_pop_back(const vec_policy* policy,
+                                      vdeque_raw* self, void* out) {
+    if (self->size == 0) {
+        return LIBV_ERR;
+    }
+    self->size--;
+    char* slot = vdeque_raw_slot(policy, self, self->size);
+    if (out) {
+        policy->obj->copy(out, slot);
+    } else if (policy->obj->dtor) {
+        policy->obj->dtor(slot);
+    }
+    return LIBV_OK;
+}
+
+static inline int vdeque_raw_pop_front(const vec_policy* policy,
+                                       vdeque_raw* self, void* out) {
+    if (self->size == 0) {
+        return LIBV_ERR;
+    }
+    char* slot = self->data + (self->head * policy->obj->size);
+    if (out) {
+        policy->obj->copy(out, slot);
+    } else if (policy->obj->dtor) {
+        policy->obj->dtor(slot);
+    }
+    self->head = (self->head + 1) & (self->capacity - 1);
+    self->size--;
+    return LIBV_OK;
+}
+
+// iter
+
+typedef struct {
+    const vdeque_raw* deque;
+    size_t position;
+} vdeque_raw_iter;
+
+static inline vdeque_raw_iter vdeque_raw_iter_new(const vdeque_raw* self) {
+    return (vdeque_raw_iter){self, 0};
+}
+
+static inline const void* vdeque_raw_iter_get(const vec_policy* policy,
+                                              const vdeque_raw_iter* self) {
+    return vdeque_raw_get_at(policy, self->deque, self->position);
+}
+
+static inline void vdeque_raw_iter_next(vdeque_raw_iter* self) {
+    self->position++;
+}
+
+#define VDEQUE_DECLARE(name_, policy_, type_)                                  \
+    LIBV_BEGIN                                                                 \
+    typedef struct {                                                           \
+        vdeque_raw deque;                                                      \
+    } name_;                                                                   \
+    typedef struct {                                                           \
+        const type_* first;                                                    \
+        size_t first_size;                                                     \
+        const type_* second;                                                   \
+        size_t second_size;                                                    \
+    } name_##_slices;                                                          \
+    static inline name_ name_##_new(void) {                                    \
+        return (name_){vdeque_raw_new()};                                      \
+    }                                                                          \
+    static inline name_ name_##_new_in(const libv_allocator* allocator) {      \
+        return (name_){vdeque_raw_new_in(allocator)};                          \
+    }                                                                          \
+    static inline void name_##_free(name_* self) {                             \
+        vdeque_raw_free(&policy_, &self->deque);                               \
+    }                                                                          \
+    static inline bool name_##_empty(const name_* self) {                      \
+        return vdeque_raw_empty(&self->deque);                                 \
+    }                                                                          \
+    static inline size_t name_##_size(const name_* self) {                     \
+        return vdeque_raw_size(&self->deque);                                  \
+    }                                                                          \
+    static inline size_t name_##_capacity(const name_* self) {                 \
+        return vdeque_raw_capacity(&self->deque);                              \
+    }                                                                          \
+    static inline int name_##_reserve(name_* self, size_t new_capacity) {      \
+        return vdeque_raw_reserve(&policy_, &self->deque, new_capacity);       \
+    }                                                                          \
+    static inline void name_##_clear(name_* self) {                            \
+        vdeque_raw_clear(&policy_, &self->deque);                              \
+    }                                                                          \
+    static inline const type_* name_##_get_at_unchecked(const name_* self,     \
+                                                        size_t index) {        \
+        return (const type_*)vdeque_raw_get_at_unchecked(                      \
+            &policy_, &self->deque, index);                                    \
+    }                                                                          \
+    static inline const type_* name_##_get_at(const name_* self,               \
+                                              size_t index) {                  \
+        return (const type_*)vdeque_raw_get_at(&policy_, &self->deque, index); \
+    }                                                                          \
+    static inline const type_* name_##_front(const name_* self) {              \
+        return (const type_*)vdeque_raw_front(&policy_, &self->deque);         \
+    }                                                                          \
+    static inline const type_* name_##_back(const name_* self) {               \
+        return (const type_*)vdeque_raw_back(&policy_, &self->deque);          \
+    }                                                                          \
+    static inline name_##_slices name_##_as_slices(const name_* self) {        \
+        vdeque_raw_slices s = vdeque_raw_as_slices(&policy_, &self->deque);    \
+        return (name_##_slices){s.first, s.first_size, s.second,               \
+                                s.second_size};                                \
+    }                                                                          \
+    static inline int name_##_push_back(name_* self, const type_* value) {     \
+        return vdeque_raw_push_back(&policy_, &self->deque, value);            \
+    }                                                                          \
+    static inline int name_##_push_front(name_* self, const type_* value) {    \
+        return vdeque_raw_push_front(&policy_, &self->deque, value);           \
+    }                                                                          \
+    static inline int name_##_pop_back(name_* self, type_* out) {              \
+        return vdeque_raw_pop_back(&policy_, &self->deque, out);               \
+    }                                                                          \
+    static inline int name_##_pop_front(name_* self, type_* out) {             \
+        return vdeque_raw_pop_front(&policy_, &self->deque, out);              \
+    }                                                                          \
+    typedef struct {                                                           \
+        vdeque_raw_iter it;                                                    \
+    } name_##_iter;                                                            \
+    static inline name_##_iter name_##_iter_new(const name_* self) {           \
+        return (name_##_iter){vdeque_raw_iter_new(&self->deque)};              \
+    }                                                                          \
+    static inline const type_* name_##_iter_get(const name_##_iter* self) {    \
+        return (const type_*)vdeque_raw_iter_get(&policy_, &self->it);         \
+    }                                                                          \
+    static inline void name_##_iter_next(name_##_iter* self) {                 \
+        vdeque_raw_iter_next(&self->it);                                       \
+    }                                                                          \
+    LIBV_END                                                                   \
+    /* Force a semicolon. */ struct name_##_needstrailingsemicolon_ { int x; }
+
+#define VDEQUE_DECLARE_DEFAULT(name_, type_)                                   \
+    VEC_DECLARE_DEFAULT_POLICY_(name_##_policy, type_)                         \
+    VDEQUE_DECLARE(name_, name_##_policy, type_)
+
+LIBV_END
+
+#endif // __LIBV_VDEQUE_H__
@@ -0,0 +1,173 @@
+#include "libv/vtest/vtest.h"
+#include "vdeque.h"
+#include <stdint.h>
+
+VDEQUE_DECLARE_DEFAULT(int_deque, int);
+
+TEST(vdeque, push_pop) {
+    int_deque d = int_deque_new();
+    int out;
+
+    assert_int_eq(int_deque_pop_front(&d, &out), LIBV_ERR);
+    assert_int_eq(int_deque_pop_back(&d, &out), LIBV_ERR);
+    assert_ptr_null(int_deque_front(&d));
+    assert_ptr_null(int_deque_back(&d));
+
+    for (int i = 0; i < 10; ++i) {
+        assert_int_eq(int_deque_push_back(&d, &i), LIBV_OK);
+    }
+    for (int i = -1; i > -10; --i) {
+        assert_int_eq(int_deque_push_front(&d, &i), LIBV_OK);
+    }
+    assert_uint_eq(int_deque_size(&d), 19);
+    assert_int_eq(*int_deque_front(&d), -9);
+    assert_int_eq(*int_deque_back(&d), 9);
+    for (int i = 0; i < 19; ++i) {
+        assert_int_eq(*int_deque_get_at(&d, i), i - 9);
+    }
+    assert_ptr_null(int_deque_get_at(&d, 19));
+
+    assert_int_eq(int_deque_pop_front(&d, &out), LIBV_OK);
+    assert_int_eq(out, -9);
+    assert_int_eq(int_deque_pop_back(&d, &out), LIBV_OK);
+    assert_int_eq(out, 9);
+    assert_uint_eq(int_deque_size(&d), 17);
+
+    int_deque_clear(&d);
+    assert_true(int_deque_empty(&d));
+
+    int_deque_free(&d);
+}
+
+TEST(vdeque, queue) {
+    int_deque d = int_deque_new();
+
+    // a steady state queue wraps around without growing
+    int next_in = 0;
+    int next_out = 0;
+    for (int i = 0; i < 6; ++i) {
+        assert_int_eq(int_deque_push_back(&d, &next_in), LIBV_OK);
+        next_in++;
+    }
+    size_t capacity = int_deque_capacity(&d);
+    for (int round = 0; round < 100000; ++round) {
+        assert_int_eq(int_deque_push_back(&d, &next_in), LIBV_OK);
+        next_in++;
+        int out;
+        assert_int_eq(int_deque_pop_front(&d, &out), LIBV_OK);
+        assert_int_eq(out, next_out);
+        next_out++;
+    }
+    assert_uint_eq(int_deque_capacity(&d), capacity);
+
+    int_deque_free(&d);
+}
+
+TEST(vdeque, grow_wrapped) {
+    int_deque d = int_deque_new();
+
+    // leave the elements wrapped around the end of the buffer, then grow
+    for (int i = 0; i < 8; ++i) {
+        assert_int_eq(int_deque_push_back(&d, &i), LIBV_OK);
+    }
+    for (int i = 0; i < 5; ++i) {
+        assert_int_eq(int_deque_pop_front(&d, NULL), LIBV_OK);
+    }
+    for (int i = 8; i < 13; ++i) {
+        assert_int_eq(int_deque_push_back(&d, &i), LIBV_OK);
+    }
+    assert_uint_eq(int_deque_capacity(&d), 8);
+    assert_int_eq(int_deque_reserve(&d, 100), LIBV_OK);
+    assert_uint_eq(int_deque_capacity(&d), 128);
+
+    int i = 5;
+    for (int_deque_iter it = int_deque_iter_new(&d); int_deque_iter_get(&it);
+         int_deque_iter_next(&it)) {
+        assert_int_eq(*int_deque_iter_get(&it), i);
+        i++;
+    }
+    assert_int_eq(i, 13);
+
+    int_deque_free(&d);
+}
+
+TEST(vdeque, slices) {
+    int_deque d = int_deque_new();
+
+    int_deque_slices s = int_deque_as_slices(&d);
+    assert_uint_eq(s.first_size + s.second_size, 0);
+
+    for (int i = 0; i < 6; ++i) {
+        assert_int_eq(int_deque_push_back(&d, &i), LIBV_OK);
+    }
+    s = int_deque_as_slices(&d);
+    assert_uint_eq(s.first_size, 6);
+    assert_uint_eq(s.second_size, 0);
+
+    for (int i = -1; i > -3; --i) {
+        assert_int_eq(int_deque_push_front(&d, &i), LIBV_OK);
+    }
+    s = int_deque_as_slices(&d);
+    assert_uint_eq(s.first_size, 2);
+    assert_uint_eq(s.second_size, 6);
+
+    int expected[] = {-2, -1, 0, 1, 2, 3, 4, 5};
+    assert_mem_eq(s.first, expected, s.first_size * sizeof(int));
+    assert_mem_eq(s.second, expected + s.first_size,
+                  s.second_size * sizeof(int));
+
+    int_deque_free(&d);
+}
+
+static size_t dtor_calls = 0;
+
+static void counted_copy(void* dst, const void* src) {
+    memcpy(dst, src, sizeof(int));
+}
+
+static bool counted_eq(const void* a, const void* b) {
+    return *(const int*)a == *(const int*)b;
+}
+
+static void counted_dtor(void* value) {
+    LIBV_UNUSED(value);
+    dtor_calls++;
+}
+
+static const vec_object_policy counted_object_policy = {
+    sizeof(int), _Alignof(int), counted_copy, counted_eq, counted_dtor,
+};
+
+static const libv_alloc_policy counted_alloc_policy = {
+    libv_default_alloc,
+    NULL,
+    libv_default_realloc,
+    libv_default_free,
+};
+
+static const vec_policy counted_policy = {
+    &counted_alloc_policy,
+    &counted_object_policy,
+};
+
+VDEQUE_DECLARE(counted_deque, counted_policy, int);
+
+TEST(vdeque, dtor) {
+    counted_deque d = counted_deque_new();
+    for (int i = 0; i < 20; ++i) {
+        assert_int_eq(counted_deque_push_front(&d, &i), LIBV_OK);
+    }
+
+    int out;
+    assert_int_eq(counted_deque_pop_front(&d, &out), LIBV_OK);
+    assert_uint_eq(dtor_calls, 0);
+    assert_int_eq(counted_deque_pop_front(&d, NULL), LIBV_OK);
+    assert_int_eq(counted_deque_pop_back(&d, NULL), LIBV_OK);
+    assert_uint_eq(dtor_calls, 2);
+
+    counted_deque_free(&d);
+    // the value popped into out was moved, not destroyed
+    assert_uint_eq(dtor_calls, 19);
+}
+
+VTEST_MAIN()
@@ -36,6 +36,26 @@
 #include <memory.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+// the bitwise search kernels use the widest vectors the target was compiled
+// for, eg. -mavx2. sse2 is part of x86-64, everything else is scalar. define
+// LIBV_VEC_SIMD_WIDTH as 0 to force the scalar loops.
+#ifndef LIBV_VEC_SIMD_WIDTH
+#if defined(__AVX2__)
+#define LIBV_VEC_SIMD_WIDTH 32
+#elif defined(__SSE2__) || defined(_M_X64)
+#define LIBV_VEC_SIMD_WIDTH 16
+#else
+#define LIBV_VEC_SIMD_WIDTH 0
+#endif // __AVX2__
+#endif // LIBV_VEC_SIMD_WIDTH
+
+#if LIBV_VEC_SIMD_WIDTH == 32
+#include <immintrin.h>
+#elif LIBV_VEC_SIMD_WIDTH == 16
+#include <emmintrin.h>
+#endif // LIBV_VEC_SIMD_WIDTH
 
 LIBV_BEGIN
 
@@ -43,6 +63,8 @@ typedef struct {
     char* data;
     size_t size;
     size_t capacity;
+    // when set, storage comes from here instead of the policy's alloc
+    const libv_allocator* allocator;
 } vec_raw;
 
 typedef struct {
@@ -65,14 +87,27 @@ static inline vec_raw vec_raw_new(void) {
     return self;
 }
 
+static inline vec_raw vec_raw_new_in(const libv_allocator* allocator) {
+    vec_raw self = {0};
+    self.allocator = allocator;
+    return self;
+}
+
 static inline void vec_raw_free(const vec_policy* policy, vec_raw* self) {
     if (policy->obj->dtor) {
         for (size_t i = 0; i < self->size; ++i) {
             policy->obj->dtor(self->data + (policy->obj->size * i));
         }
     }
-    policy->alloc->free(self->data, self->capacity * policy->obj->size,
-                        policy->obj->align);
+    if (self->allocator) {
+        self->allocator->free(self->allocator->ctx, self->data,
+                              self->capacity * policy->obj->size,
+                              policy->obj->align);
+    } else {
+        policy->alloc->free(self->data, self->capacity * policy->obj->size,
+                            policy->obj->align);
+    }
+    self->data = NULL;
     self->size = 0;
     self->capacity = 0;
 }
@@ -91,10 +126,17 @@ static inline size_t vec_raw_capacity(const vec_raw* self) {
 
 static inline int vec_raw_realloc_self(const vec_policy* policy, vec_raw* self,
                                        size_t new_capacity) {
-    void* tmp = policy->alloc->realloc(
-        self->data, self->capacity * policy->obj->size,
-        new_capacity * policy->obj->size, policy->obj->align);
-    if (!tmp) {
+    size_t old_size = self->capacity * policy->obj->size;
+    size_t new_size = new_capacity * policy->obj->size;
+    void* tmp;
+    if (self->allocator) {
+        tmp = self->allocator->realloc(self->allocator->ctx, self->data,
+                                       old_size, new_size, policy->obj->align);
+    } else {
+        tmp = policy->alloc->realloc(self->data, old_size, new_size,
+                                     policy->obj->align);
+    }
+    if (!tmp && new_size != 0) {
         return LIBV_ERR;
     }
     self->data = tmp;
@@ -163,15 +205,250 @@ static inline const void* vec_raw_data(const vec_raw* self) {
     return self->data;
 }
 
+#define VEC_NPOS SIZE_MAX
+
+// the index of the first element equal to needle, VEC_NPOS if there is none
+static inline size_t vec_raw_index_of(const vec_policy* policy,
+                                      const vec_raw* self, const void* needle) {
+    for (size_t i = 0; i < self->size; ++i) {
+        const void* candidate = self->data + i * policy->obj->size;
+        if (policy->obj->eq(needle, candidate)) {
+            return i;
+        }
+    }
+    return VEC_NPOS;
+}
+
 static inline bool vec_raw_contains(const vec_policy* policy,
                                     const vec_raw* self, const void* needle) {
+    return vec_raw_index_of(policy, self, needle) != VEC_NPOS;
+}
+
+static inline size_t vec_raw_count(const vec_policy* policy,
+                                   const vec_raw* self, const void* needle) {
+    size_t count = 0;
     for (size_t i = 0; i < self->size; ++i) {
         const void* candidate = self->data + i * policy->obj->size;
-        if (policy->obj->eq(needle, candidate)) {
-            return true;
+        count += policy->obj->eq(needle, candidate);
+    }
+    return count;
+}
+
+// bitwise search
+// the same searches for elements compared with memcmp. elements of 1, 2, 4
+// or 8 bytes are compared a vector at a time. width is always a sizeof, so
+// the switches below fold away once inlined.
+
+static inline uint32_t vec_trailing_zeros32(uint32_t x) {
+#if LIBV_HAVE_CLANG_BUILTIN(__builtin_ctz) || LIBV_IS_GCC
+    return x == 0 ? 32 : (uint32_t)__builtin_ctz(x);
+#elif LIBV_IS_MSVC
+    unsigned long result = 0;
+    if (_BitScanForward(&result, x)) {
+        return result;
+    }
+    return 32;
+#else
+    uint32_t zeroes = 0;
+    if (x == 0) {
+        return 32;
+    }
+    while ((x & 1) == 0) {
+        x >>= 1;
+        zeroes++;
+    }
+    return zeroes;
+#endif
+}
+
+static inline uint32_t vec_popcount32(uint32_t x) {
+#if LIBV_HAVE_CLANG_BUILTIN(__builtin_popcount) || LIBV_IS_GCC
+    return (uint32_t)__builtin_popcount(x);
+#else
+    x = x - ((x >> 1) & 0x55555555);
+    x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+    x = (x + (x >> 4)) & 0x0f0f0f0f;
+    return (x * 0x01010101) >> 24;
+#endif
+}
+
+LIBV_INLINE_ALWAYS static inline uint64_t vec_load_lane(const char* p,
+                                                        size_t width) {
+    switch (width) {
+    case 1: {
+        uint8_t x;
+        memcpy(&x, p, sizeof x);
+        return x;
+    }
+    case 2: {
+        uint16_t x;
+        memcpy(&x, p, sizeof x);
+        return x;
+    }
+    case 4: {
+        uint32_t x;
+        memcpy(&x, p, sizeof x);
+        return x;
+    }
+    default: {
+        uint64_t x;
+        memcpy(&x, p, sizeof x);
+        return x;
+    }
+    }
+}
+
+#if LIBV_VEC_SIMD_WIDTH == 32
+
+typedef __m256i vec_simd_reg;
+
+LIBV_INLINE_ALWAYS static inline vec_simd_reg vec_simd_load(const char* p) {
+    return _mm256_loadu_si256((const __m256i*)p);
+}
+
+LIBV_INLINE_ALWAYS static inline vec_simd_reg vec_simd_splat(uint64_t lane,
+                                                             size_t width) {
+    switch (width) {
+    case 1:
+        return _mm256_set1_epi8((char)lane);
+    case 2:
+        return _mm256_set1_epi16((short)lane);
+    case 4:
+        return _mm256_set1_epi32((int)lane);
+    default:
+        return _mm256_set1_epi64x((long long)lane);
+    }
+}
+
+// one bit per byte, set in every byte of a lane equal to the needle
+LIBV_INLINE_ALWAYS static inline uint32_t
+vec_simd_eq_mask(vec_simd_reg a, vec_simd_reg b, size_t width) {
+    vec_simd_reg eq;
+    switch (width) {
+    case 1:
+        eq = _mm256_cmpeq_epi8(a, b);
+        break;
+    case 2:
+        eq = _mm256_cmpeq_epi16(a, b);
+        break;
+    case 4:
+        eq = _mm256_cmpeq_epi32(a, b);
+        break;
+    default:
+        eq = _mm256_cmpeq_epi64(a, b);
+        break;
+    }
+    return (uint32_t)_mm256_movemask_epi8(eq);
+}
+
+#elif LIBV_VEC_SIMD_WIDTH == 16
+
+typedef __m128i vec_simd_reg;
+
+LIBV_INLINE_ALWAYS static inline vec_simd_reg vec_simd_load(const char* p) {
+    return _mm_loadu_si128((const __m128i*)p);
+}
+
+LIBV_INLINE_ALWAYS static inline vec_simd_reg vec_simd_splat(uint64_t lane,
+                                                             size_t width) {
+    switch (width) {
+    case 1:
+        return _mm_set1_epi8((char)lane);
+    case 2:
+        return _mm_set1_epi16((short)lane);
+    case 4:
+        return _mm_set1_epi32((int)lane);
+    default:
+        return _mm_set1_epi64x((long long)lane);
+    }
+}
+
+// one bit per byte, set in every byte of a lane equal to the needle
+LIBV_INLINE_ALWAYS static inline uint32_t
+vec_simd_eq_mask(vec_simd_reg a, vec_simd_reg b, size_t width) {
+    vec_simd_reg eq;
+    switch (width) {
+    case 1:
+        eq = _mm_cmpeq_epi8(a, b);
+        break;
+    case 2:
+        eq = _mm_cmpeq_epi16(a, b);
+        break;
+    case 4:
+        eq = _mm_cmpeq_epi32(a, b);
+        break;
+    default:
+        // sse2 has no 64 bit compare, both 32 bit halves have to match
+        eq = _mm_cmpeq_epi32(a, b);
+        eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+        break;
+    }
+    return (uint32_t)_mm_movemask_epi8(eq);
+}
+
+#endif // LIBV_VEC_SIMD_WIDTH
+
+static inline bool vec_is_lane_width(size_t width) {
+    return width == 1 || width == 2 || width == 4 || width == 8;
+}
+
+LIBV_INLINE_ALWAYS static inline size_t
+vec_raw_bitwise_index_of(const char* data, size_t size, const void* needle,
+                         size_t width) {
+    size_t i = 0;
+    if (!vec_is_lane_width(width)) {
+        for (; i < size; ++i) {
+            if (memcmp(data + i * width, needle, width) == 0) {
+                return i;
+            }
+        }
+        return VEC_NPOS;
+    }
+    uint64_t lane = vec_load_lane(needle, width);
+#if LIBV_VEC_SIMD_WIDTH
+    size_t lanes = LIBV_VEC_SIMD_WIDTH / width;
+    vec_simd_reg splat = vec_simd_splat(lane, width);
+    for (; i + lanes <= size; i += lanes) {
+        uint32_t mask =
+            vec_simd_eq_mask(vec_simd_load(data + i * width), splat, width);
+        if (mask) {
+            return i + vec_trailing_zeros32(mask) / width;
+        }
+    }
+#endif // LIBV_VEC_SIMD_WIDTH
+    for (; i < size; ++i) {
+        if (vec_load_lane(data + i * width, width) == lane) {
+            return i;
         }
     }
-    return false;
+    return VEC_NPOS;
+}
+
+LIBV_INLINE_ALWAYS static inline size_t
+vec_raw_bitwise_count(const char* data, size_t size, const void* needle,
+                      size_t width) {
+    size_t i = 0;
+    size_t count = 0;
+    if (!vec_is_lane_width(width)) {
+        for (; i < size; ++i) {
+            count += memcmp(data + i * width, needle, width) == 0;
+        }
+        return count;
+    }
+    uint64_t lane = vec_load_lane(needle, width);
+#if LIBV_VEC_SIMD_WIDTH
+    size_t lanes = LIBV_VEC_SIMD_WIDTH / width;
+    vec_simd_reg splat = vec_simd_splat(lane, width);
+    for (; i + lanes <= size; i += lanes) {
+        uint32_t mask =
+            vec_simd_eq_mask(vec_simd_load(data + i * width), splat, width);
+        count += vec_popcount32(mask) / width;
+    }
+#endif // LIBV_VEC_SIMD_WIDTH
+    for (; i < size; ++i) {
+        count += vec_load_lane(data + i * width, width) == lane;
+    }
+    return count;
 }
 
 static inline const void* vec_raw_front(const vec_raw* self) {
@@ -189,6 +466,21 @@ static inline const void* vec_raw_back(const vec_policy* policy,
     return self->data + ((self->size - 1) * policy->obj->size);
 }
 
+static inline void* vec_raw_get_at_mut(const vec_policy* policy, vec_raw* self,
+                                       size_t index) {
+    if (index >= self->size) {
+        return NULL;
+    }
+    return self->data + (index * policy->obj->size);
+}
+
+static inline void* vec_raw_back_mut(const vec_policy* policy, vec_raw* self) {
+    if (self->size == 0) {
+        return NULL;
+    }
+    return self->data + ((self->size - 1) * policy->obj->size);
+}
+
 // modification
 
 static inline void vec_raw_remove_at_unchecked(const vec_policy* policy,
@@ -219,6 +511,89 @@ static inline int vec_raw_remove_at(const vec_policy* policy, vec_raw* self,
     return LIBV_OK;
 }
 
+// removes the element at index by moving the last element into its place
+static inline int vec_raw_swap_remove(const vec_policy* policy, vec_raw* self,
+                                      size_t index, void* out) {
+    if (index >= self->size) {
+        return LIBV_ERR;
+    }
+    char* slot = self->data + (index * policy->obj->size);
+    if (out) {
+        policy->obj->copy(out, slot);
+    } else if (policy->obj->dtor) {
+        policy->obj->dtor(slot);
+    }
+    self->size--;
+    if (index != self->size) {
+        memcpy(slot, self->data + (self->size * policy->obj->size),
+               policy->obj->size);
+    }
+    return LIBV_OK;
+}
+
+// removes the elements in [start, end)
+static inline int vec_raw_remove_range(const vec_policy* policy, vec_raw* self,
+                                       size_t start, size_t end) {
+    if (start > end || end > self->size) {
+        return LIBV_ERR;
+    }
+    size_t size = policy->obj->size;
+    if (policy->obj->dtor) {
+        for (size_t i = start; i < end; ++i) {
+            policy->obj->dtor(self->data + (i * size));
+        }
+    }
+    memmove(self->data + (start * size), self->data + (end * size),
+            (self->size - end) * size);
+    self->size -= end - start;
+    return LIBV_OK;
+}
+
+typedef bool (*vec_pred_fn)(void* ctx, const void* value);
+
+// keeps the elements pred returns keep for, in order, and destroys the rest.
+// every run of kept elements is moved with one memmove, so the whole pass is
+// linear.
+LIBV_INLINE_ALWAYS static inline size_t
+vec_raw_filter_(const vec_policy* policy, vec_raw* self, vec_pred_fn pred,
+                void* ctx, bool keep) {
+    size_t size = policy->obj->size;
+    size_t kept = 0;
+    size_t i = 0;
+    while (i < self->size) {
+        size_t run = i;
+        while (i < self->size && pred(ctx, self->data + (i * size)) == keep) {
+            i++;
+        }
+        if (run != kept) {
+            memmove(self->data + (kept * size), self->data + (run * size),
+                    (i - run) * size);
+        }
+        kept += i - run;
+        if (i < self->size) {
+            if (policy->obj->dtor) {
+                policy->obj->dtor(self->data + (i * size));
+            }
+            i++;
+        }
+    }
+    size_t removed = self->size - kept;
+    self->size = kept;
+    return removed;
+}
+
+// keeps the elements pred returns true for, returns how many were removed
+static inline size_t vec_raw_retain(const vec_policy* policy, vec_raw* self,
+                                    vec_pred_fn pred, void* ctx) {
+    return vec_raw_filter_(policy, self, pred, ctx, true);
+}
+
+// removes the elements pred returns true for, returns how many were removed
+static inline size_t vec_raw_remove_if(const vec_policy* policy, vec_raw* self,
+                                       vec_pred_fn pred, void* ctx) {
+    return vec_raw_filter_(policy, self, pred, ctx, false);
+}
+
 static inline int vec_raw_pop_front(const vec_policy* policy, vec_raw* self,
                                     void* out) {
     return vec_raw_remove_at(policy, self, 0, out);
@@ -267,21 +642,70 @@ static inline int vec_raw_push_back(const vec_policy* policy, vec_raw* self,
     return LIBV_OK;
 }
 
+// appends an uninitialized element and returns it, NULL if growing failed.
+// it already counts towards size, so it has to be constructed before the vec
+// is used again.
+static inline void* vec_raw_emplace_back(const vec_policy* policy,
+                                         vec_raw* self) {
+    if (vec_raw_maybe_resize(policy, self) == LIBV_ERR) {
+        return NULL;
+    }
+    return self->data + (self->size++ * policy->obj->size);
+}
+
+// the same for count elements, returns the first of them
+static inline void* vec_raw_extend_uninit(const vec_policy* policy,
+                                          vec_raw* self, size_t count) {
+    if (vec_raw_reserve(policy, self, self->size + count) == LIBV_ERR) {
+        return NULL;
+    }
+    void* first = self->data + (self->size * policy->obj->size);
+    self->size += count;
+    return first;
+}
+
 static inline int vec_raw_append(const vec_policy* policy, vec_raw* self,
                                  const vec_raw* other) {
     if (vec_raw_reserve(policy, self, self->size + other->size) == LIBV_ERR) {
         return LIBV_ERR;
     }
+    // capacity is already there, so copy straight into place
     for (size_t i = 0; i < other->size; ++i) {
-        if (vec_raw_push_back(policy, self,
-                              other->data + (i * policy->obj->size)) ==
-            LIBV_ERR) {
-            return LIBV_ERR;
-        }
+        policy->obj->copy(self->data + ((self->size + i) * policy->obj->size),
+                          other->data + (i * policy->obj->size));
+    }
+    self->size += other->size;
+    return LIBV_OK;
+}
+
+// inserts count values before index, index may be size
+static inline int vec_raw_insert_range(const vec_policy* policy, vec_raw* self,
+                                       size_t index, const void* values,
+                                       size_t count) {
+    if (index > self->size) {
+        return LIBV_ERR;
+    }
+    if (vec_raw_reserve(policy, self, self->size + count) == LIBV_ERR) {
+        return LIBV_ERR;
+    }
+    size_t size = policy->obj->size;
+    memmove(self->data + ((index + count) * size), self->data + (index * size),
+            (self->size - index) * size);
+    for (size_t i = 0; i < count; ++i) {
+        policy->obj->copy(self->data + ((index + i) * size),
+                          (const char*)values + (i * size));
     }
+    self->size += count;
     return LIBV_OK;
 }
 
+// replaces the contents of dst with copies of the elements of src
+static inline int vec_raw_copy(const vec_policy* policy, vec_raw* dst,
+                               const vec_raw* src) {
+    vec_raw_clear(policy, dst);
+    return vec_raw_append(policy, dst, src);
+}
+
 // iter
 
 typedef struct {
@@ -301,9 +725,17 @@ static inline const void* vec_raw_iter_get(const vec_policy* policy,
     return self->vec->data + (self->position * policy->obj->size);
 }
 
+static inline void* vec_raw_iter_get_mut(const vec_policy* policy,
+                                         const vec_raw_iter* self) {
+    if (self->position >= self->vec->size) {
+        return NULL;
+    }
+    return self->vec->data + (self->position * policy->obj->size);
+}
+
 static inline void vec_raw_iter_next(vec_raw_iter* self) { self->position++; }
 
-#define VEC_DECLARE_DEFAULT_POLICY_(policy_, type_)                            \
+#define VEC_DECLARE_ALIGNED_POLICY_(policy_, type_, align_)                    \
     LIBV_BEGIN                                                                 \
     static inline void policy_##_default_copy(void* dst, const void* src) {    \
         memcpy(dst, src, sizeof(type_));                                       \
@@ -313,7 +745,7 @@ static inline void vec_raw_iter_next(vec_raw_iter* self) { self->position++; }
     }                                                                          \
     static const vec_object_policy policy_##_object_policy = {                 \
         sizeof(type_),                                                         \
-        _Alignof(type_),                                                       \
+        (align_) > _Alignof(type_) ? (align_) : _Alignof(type_),               \
         policy_##_default_copy,                                                \
         policy_##_default_eq,                                                  \
         NULL,                                                                  \
@@ -330,33 +762,134 @@ static inline void vec_raw_iter_next(vec_raw_iter* self) { self->position++; }
         &policy_##_object_policy,                                              \
     };
 
-#define VEC_DECLARE(name_, policy_, type_)                                     \
-    LIBV_BEGIN                                                                 \
-    typedef struct {                                                           \
-        vec_raw vec;                                                           \
-    } name_;                                                                   \
-    static inline name_ name_##_new(void) { return (name_){vec_raw_new()}; }   \
-    static inline void name_##_free(name_* self) {                             \
-        vec_raw_free(&policy_, &self->vec);                                    \
-    }                                                                          \
+#define VEC_DECLARE_DEFAULT_POLICY_(policy_, type_)                            \
+    VEC_DECLARE_ALIGNED_POLICY_(policy_, type_, _Alignof(type_))
+
+// the parts of the interface that only read or drop elements, shared with
+// vecs that are not created and freed through policy_, eg. vec_mmap.h
+#define VEC_DECLARE_ELEMENTS_(name_, policy_, type_)                           \
     static inline bool name_##_empty(const name_* self) {                      \
         return vec_raw_empty(&self->vec);                                      \
     }                                                                          \
     static inline size_t name_##_size(const name_* self) {                     \
         return vec_raw_size(&self->vec);                                       \
     }                                                                          \
+    static inline void name_##_clear(name_* self) {                            \
+        vec_raw_clear(&policy_, &self->vec);                                   \
+    }                                                                          \
+    typedef struct {                                                           \
+        vec_raw_iter it;                                                       \
+    } name_##_iter;                                                            \
+    static inline name_##_iter name_##_iter_new(name_* self) {                 \
+        return (name_##_iter){vec_raw_iter_new(&self->vec)};                   \
+    }                                                                          \
+    static inline void name_##_iter_next(name_##_iter* self) {                 \
+        vec_raw_iter_next(&self->it);                                          \
+    }                                                                          \
+    typedef bool (*name_##_pred)(void* ctx, const type_* value);
+
+#define VEC_DECLARE_COMMON_(name_, policy_, type_)                             \
+    static inline name_ name_##_new(void) { return (name_){vec_raw_new()}; }   \
+    static inline name_ name_##_new_in(const libv_allocator* allocator) {      \
+        return (name_){vec_raw_new_in(allocator)};                             \
+    }                                                                          \
+    static inline void name_##_free(name_* self) {                             \
+        vec_raw_free(&policy_, &self->vec);                                    \
+    }                                                                          \
+    VEC_DECLARE_ELEMENTS_(name_, policy_, type_)
+
+// where the elements of a contiguous vec live
+#define VEC_DECLARE_VIEW_(name_, type_)                                        \
+    static inline type_* name_##_storage(const name_* self) {                  \
+        return (type_*)self->vec.data;                                         \
+    }                                                                          \
     static inline size_t name_##_capacity(const name_* self) {                 \
         return vec_raw_capacity(&self->vec);                                   \
     }                                                                          \
+    static inline const type_* name_##_data(const name_* self) {               \
+        return (const type_*)vec_raw_data(&self->vec);                         \
+    }                                                                          \
+    static inline const type_* name_##_front(const name_* self) {              \
+        return (const type_*)vec_raw_front(&self->vec);                        \
+    }
+
+// where the elements live and how the vec grows. storage and grow are only
+// used by VEC_DECLARE_TRIVIAL_.
+#define VEC_DECLARE_STORAGE_(name_, policy_, type_)                            \
+    VEC_DECLARE_VIEW_(name_, type_)                                            \
+    static inline int name_##_grow(name_* self) {                              \
+        return vec_raw_maybe_resize(&policy_, &self->vec);                     \
+    }                                                                          \
     static inline int name_##_reserve(name_* self, size_t new_capacity) {      \
         return vec_raw_reserve(&policy_, &self->vec, new_capacity);            \
     }                                                                          \
     static inline int name_##_shrink_to_size(name_* self) {                    \
         return vec_raw_shrink_to_size(&policy_, &self->vec);                   \
+    }
+
+// the elements live in self->buffer until they outgrow it. self->vec.data is
+// only used, and self->vec.capacity only non zero, once they have spilled to
+// the heap, so the struct can still be moved by value.
+#define VEC_DECLARE_INLINE_STORAGE_(name_, policy_, type_, n_)                 \
+    static inline type_* name_##_storage(const name_* self) {                  \
+        if (self->vec.capacity == 0) {                                         \
+            return (type_*)self->buffer;                                       \
+        }                                                                      \
+        return (type_*)self->vec.data;                                         \
     }                                                                          \
-    static inline void name_##_clear(name_* self) {                            \
-        vec_raw_clear(&policy_, &self->vec);                                   \
+    static inline size_t name_##_capacity(const name_* self) {                 \
+        return self->vec.capacity == 0 ? (n_) : self->vec.capacity;            \
+    }                                                                          \
+    static inline int name_##_reserve(name_* self, size_t new_capacity) {      \
+        if (new_capacity <= name_##_capacity(self)) {                          \
+            return LIBV_OK;                                                    \
+        }                                                                      \
+        bool spill = self->vec.capacity == 0;                                  \
+        if (vec_raw_realloc_self(&policy_, &self->vec, new_capacity) ==        \
+            LIBV_ERR) {                                                        \
+            return LIBV_ERR;                                                   \
+        }                                                                      \
+        if (spill) {                                                           \
+            memcpy(self->vec.data, self->buffer,                               \
+                   self->vec.size * sizeof(type_));                            \
+        }                                                                      \
+        return LIBV_OK;                                                        \
+    }                                                                          \
+    static inline int name_##_grow(name_* self) {                              \
+        size_t capacity = name_##_capacity(self);                              \
+        if (self->vec.size < capacity) {                                       \
+            return LIBV_OK;                                                    \
+        }                                                                      \
+        return name_##_reserve(self, capacity >= 1024                          \
+                                         ? capacity + (capacity / 2)           \
+                                         : capacity << 1);                     \
     }                                                                          \
+    /* moves the elements back into the buffer once they fit again */          \
+    static inline int name_##_shrink_to_size(name_* self) {                    \
+        if (self->vec.capacity == 0) {                                         \
+            return LIBV_OK;                                                    \
+        }                                                                      \
+        size_t size = self->vec.size;                                          \
+        if (size > (n_)) {                                                     \
+            return vec_raw_shrink_to_size(&policy_, &self->vec);               \
+        }                                                                      \
+        memcpy(self->buffer, self->vec.data, size * sizeof(type_));            \
+        self->vec.size = 0;                                                    \
+        vec_raw_free(&policy_, &self->vec);                                    \
+        self->vec.size = size;                                                 \
+        return LIBV_OK;                                                        \
+    }                                                                          \
+    static inline const type_* name_##_data(const name_* self) {               \
+        return name_##_storage(self);                                          \
+    }                                                                          \
+    static inline const type_* name_##_front(const name_* self) {              \
+        if (self->vec.size == 0) {                                             \
+            return NULL;                                                       \
+        }                                                                      \
+        return name_##_storage(self);                                          \
+    }
+
+#define VEC_DECLARE_GENERIC_(name_, policy_, type_)                            \
     static inline const type_* name_##_get_at_unchecked(const name_* self,     \
                                                         size_t index) {        \
         return (const type_*)vec_raw_get_at_unchecked(&policy_, &self->vec,    \
@@ -366,19 +899,15 @@ static inline void vec_raw_iter_next(vec_raw_iter* self) { self->position++; }
                                               size_t index) {                  \
         return (const type_*)vec_raw_get_at(&policy_, &self->vec, index);      \
     }                                                                          \
-    static inline const type_* name_##_data(const name_* self) {               \
-        return (const type_*)vec_raw_data(&self->vec);                         \
-    }                                                                          \
-    static inline bool name_##_contains(const name_* self,                     \
-                                        const type_* needle) {                 \
-        return vec_raw_contains(&policy_, &self->vec, needle);                 \
-    }                                                                          \
-    static inline const type_* name_##_front(const name_* self) {              \
-        return (const type_*)vec_raw_front(&self->vec);                        \
-    }                                                                          \
     static inline const type_* name_##_back(const name_* self) {               \
         return (const type_*)vec_raw_back(&policy_, &self->vec);               \
     }                                                                          \
+    static inline type_* name_##_get_at_mut(name_* self, size_t index) {       \
+        return (type_*)vec_raw_get_at_mut(&policy_, &self->vec, index);        \
+    }                                                                          \
+    static inline type_* name_##_back_mut(name_* self) {                       \
+        return (type_*)vec_raw_back_mut(&policy_, &self->vec);                 \
+    }                                                                          \
     static inline void name_##_remove_at_unchecked(name_* self, size_t index,  \
                                                    type_* out) {               \
         vec_raw_remove_at_unchecked(&policy_, &self->vec, index, out);         \
@@ -387,6 +916,35 @@ static inline void vec_raw_iter_next(vec_raw_iter* self) { self->position++; }
                                         type_* out) {                          \
         return vec_raw_remove_at(&policy_, &self->vec, index, out);            \
     }                                                                          \
+    static inline int name_##_swap_remove(name_* self, size_t index,           \
+                                          type_* out) {                        \
+        return vec_raw_swap_remove(&policy_, &self->vec, index, out);          \
+    }                                                                          \
+    static inline int name_##_remove_range(name_* self, size_t start,          \
+                                           size_t end) {                       \
+        return vec_raw_remove_range(&policy_, &self->vec, start, end);         \
+    }                                                                          \
+    typedef struct {                                                           \
+        name_##_pred pred;                                                     \
+        void* ctx;                                                             \
+    } name_##_pred_closure;                                                    \
+    static inline bool name_##_pred_call(void* ctx, const void* value) {       \
+        const name_##_pred_closure* closure =                                  \
+            (const name_##_pred_closure*)ctx;                                  \
+        return closure->pred(closure->ctx, (const type_*)value);               \
+    }                                                                          \
+    static inline size_t name_##_retain(name_* self, name_##_pred pred,        \
+                                        void* ctx) {                           \
+        name_##_pred_closure closure = {pred, ctx};                            \
+        return vec_raw_retain(&policy_, &self->vec, name_##_pred_call,         \
+                              &closure);                                       \
+    }                                                                          \
+    static inline size_t name_##_remove_if(name_* self, name_##_pred pred,     \
+                                           void* ctx) {                        \
+        name_##_pred_closure closure = {pred, ctx};                            \
+        return vec_raw_remove_if(&policy_, &self->vec, name_##_pred_call,      \
+                                 &closure);                                    \
+    }                                                                          \
     static inline int name_##_pop_front(name_* self, type_* out) {             \
         return vec_raw_pop_front(&policy_, &self->vec, out);                   \
     }                                                                          \
@@ -399,27 +957,317 @@ static inline void vec_raw_iter_next(vec_raw_iter* self) { self->position++; }
     static inline int name_##_push_back(name_* self, const type_* value) {     \
         return vec_raw_push_back(&policy_, &self->vec, value);                 \
     }                                                                          \
+    static inline type_* name_##_emplace_back(name_* self) {                   \
+        return (type_*)vec_raw_emplace_back(&policy_, &self->vec);             \
+    }                                                                          \
+    static inline type_* name_##_extend_uninit(name_* self, size_t count) {    \
+        return (type_*)vec_raw_extend_uninit(&policy_, &self->vec, count);     \
+    }                                                                          \
     static inline int name_##_append(name_* self, const name_* other) {        \
         return vec_raw_append(&policy_, &self->vec, &other->vec);              \
     }                                                                          \
-    typedef struct {                                                           \
-        vec_raw_iter it;                                                       \
-    } name_##_iter;                                                            \
-    static inline name_##_iter name_##_iter_new(name_* self) {                 \
-        return (name_##_iter){vec_raw_iter_new(&self->vec)};                   \
+    static inline int name_##_insert_range(                                    \
+        name_* self, size_t index, const type_* values, size_t count) {        \
+        return vec_raw_insert_range(&policy_, &self->vec, index, values,       \
+                                    count);                                    \
+    }                                                                          \
+    static inline int name_##_copy(name_* self, const name_* other) {          \
+        return vec_raw_copy(&policy_, &self->vec, &other->vec);                \
+    }                                                                          \
+    static inline size_t name_##_index_of(const name_* self,                   \
+                                          const type_* needle) {               \
+        return vec_raw_index_of(&policy_, &self->vec, needle);                 \
+    }                                                                          \
+    static inline const type_* name_##_find(const name_* self,                 \
+                                            const type_* needle) {             \
+        size_t index = vec_raw_index_of(&policy_, &self->vec, needle);         \
+        if (index == VEC_NPOS) {                                               \
+            return NULL;                                                       \
+        }                                                                      \
+        return name_##_get_at_unchecked(self, index);                          \
+    }                                                                          \
+    static inline bool name_##_contains(const name_* self,                     \
+                                        const type_* needle) {                 \
+        return vec_raw_contains(&policy_, &self->vec, needle);                 \
+    }                                                                          \
+    static inline size_t name_##_count(const name_* self,                      \
+                                       const type_* needle) {                  \
+        return vec_raw_count(&policy_, &self->vec, needle);                    \
     }                                                                          \
     static inline const type_* name_##_iter_get(const name_##_iter* self) {    \
         return (const type_*)vec_raw_iter_get(&policy_, &self->it);            \
     }                                                                          \
-    static inline void name_##_iter_next(name_##_iter* self) {                 \
-        vec_raw_iter_next(&self->it);                                          \
+    static inline type_* name_##_iter_get_mut(const name_##_iter* self) {      \
+        return (type_*)vec_raw_iter_get_mut(&policy_, &self->it);              \
+    }
+
+#define VEC_DECLARE_TRIVIAL_(name_, policy_, type_)                            \
+    static inline const type_* name_##_get_at_unchecked(const name_* self,     \
+                                                        size_t index) {        \
+        return name_##_storage(self) + index;                                  \
+    }                                                                          \
+    static inline const type_* name_##_get_at(const name_* self,               \
+                                              size_t index) {                  \
+        if (index >= self->vec.size) {                                         \
+            return NULL;                                                       \
+        }                                                                      \
+        return name_##_storage(self) + index;                                  \
+    }                                                                          \
+    static inline const type_* name_##_back(const name_* self) {               \
+        if (self->vec.size == 0) {                                             \
+            return NULL;                                                       \
+        }                                                                      \
+        return name_##_storage(self) + (self->vec.size - 1);                   \
+    }                                                                          \
+    static inline type_* name_##_get_at_mut(name_* self, size_t index) {       \
+        if (index >= self->vec.size) {                                         \
+            return NULL;                                                       \
+        }                                                                      \
+        return name_##_storage(self) + index;                                  \
+    }                                                                          \
+    static inline type_* name_##_back_mut(name_* self) {                       \
+        if (self->vec.size == 0) {                                             \
+            return NULL;                                                       \
+        }                                                                      \
+        return name_##_storage(self) + (self->vec.size - 1);                   \
+    }                                                                          \
+    static inline void name_##_remove_at_unchecked(name_* self, size_t index,  \
+                                                   type_* out) {               \
+        type_* data = name_##_storage(self);                                   \
+        if (out) {                                                             \
+            *out = data[index];                                                \
+        }                                                                      \
+        self->vec.size--;                                                      \
+        memmove(data + index, data + index + 1,                                \
+                (self->vec.size - index) * sizeof(type_));                     \
+    }                                                                          \
+    static inline int name_##_remove_at(name_* self, size_t index,             \
+                                        type_* out) {                          \
+        if (index >= self->vec.size) {                                         \
+            return LIBV_ERR;                                                   \
+        }                                                                      \
+        name_##_remove_at_unchecked(self, index, out);                         \
+        return LIBV_OK;                                                        \
+    }                                                                          \
+    static inline int name_##_swap_remove(name_* self, size_t index,           \
+                                          type_* out) {                        \
+        if (index >= self->vec.size) {                                         \
+            return LIBV_ERR;                                                   \
+        }                                                                      \
+        type_* data = name_##_storage(self);                                   \
+        if (out) {                                                             \
+            *out = data[index];                                                \
+        }                                                                      \
+        data[index] = data[--self->vec.size];                                  \
+        return LIBV_OK;                                                        \
+    }                                                                          \
+    static inline int name_##_remove_range(name_* self, size_t start,          \
+                                           size_t end) {                       \
+        if (start > end || end > self->vec.size) {                             \
+            return LIBV_ERR;                                                   \
+        }                                                                      \
+        type_* data = name_##_storage(self);                                   \
+        memmove(data + start, data + end,                                      \
+                (self->vec.size - end) * sizeof(type_));                       \
+        self->vec.size -= end - start;                                         \
+        return LIBV_OK;                                                        \
+    }                                                                          \
+    static inline size_t name_##_filter_(name_* self, name_##_pred pred,       \
+                                         void* ctx, bool keep) {               \
+        type_* data = name_##_storage(self);                                   \
+        size_t size = self->vec.size;                                          \
+        size_t kept = 0;                                                       \
+        size_t i = 0;                                                          \
+        while (i < size) {                                                     \
+            size_t run = i;                                                    \
+            while (i < size && pred(ctx, data + i) == keep) {                  \
+                i++;                                                           \
+            }                                                                  \
+            if (run != kept) {                                                 \
+                memmove(data + kept, data + run, (i - run) * sizeof(type_));   \
+            }                                                                  \
+            kept += i - run;                                                   \
+            i += i < size;                                                     \
+        }                                                                      \
+        self->vec.size = kept;                                                 \
+        return size - kept;                                                    \
+    }                                                                          \
+    static inline size_t name_##_retain(name_* self, name_##_pred pred,        \
+                                        void* ctx) {                           \
+        return name_##_filter_(self, pred, ctx, true);                         \
+    }                                                                          \
+    static inline size_t name_##_remove_if(name_* self, name_##_pred pred,     \
+                                           void* ctx) {                        \
+        return name_##_filter_(self, pred, ctx, false);                        \
+    }                                                                          \
+    static inline int name_##_pop_front(name_* self, type_* out) {             \
+        return name_##_remove_at(self, 0, out);                                \
+    }                                                                          \
+    static inline int name_##_push_front(name_* self, const type_* value) {    \
+        if (name_##_grow(self) == LIBV_ERR) {                                  \
+            return LIBV_ERR;                                                   \
+        }                                                                      \
+        type_* data = name_##_storage(self);                                   \
+        memmove(data + 1, data, self->vec.size * sizeof(type_));               \
+        data[0] = *value;                                                      \
+        self->vec.size++;                                                      \
+        return LIBV_OK;                                                        \
+    }                                                                          \
+    static inline int name_##_pop_back(name_* self, type_* out) {              \
+        if (self->vec.size == 0) {                                             \
+            return LIBV_ERR;                                                   \
+        }                                                                      \
+        self->vec.size--;                                                      \
+        if (out) {                                                             \
+            *out = name_##_storage(self)[self->vec.size];                      \
+        }                                                                      \
+        return LIBV_OK;                                                        \
+    }                                                                          \
+    static inline int name_##_push_back(name_* self, const type_* value) {     \
+        if (LIBV_UNLIKELY(self->vec.size == name_##_capacity(self)) &&         \
+            name_##_grow(self) == LIBV_ERR) {                                  \
+            return LIBV_ERR;                                                   \
+        }                                                                      \
+        name_##_storage(self)[self->vec.size++] = *value;                      \
+        return LIBV_OK;                                                        \
+    }                                                                          \
+    static inline type_* name_##_emplace_back(name_* self) {                   \
+        if (LIBV_UNLIKELY(self->vec.size == name_##_capacity(self)) &&         \
+            name_##_grow(self) == LIBV_ERR) {                                  \
+            return NULL;                                                       \
+        }                                                                      \
+        return name_##_storage(self) + self->vec.size++;                       \
     }                                                                          \
+    static inline type_* name_##_extend_uninit(name_* self, size_t count) {    \
+        if (name_##_reserve(self, self->vec.size + count) == LIBV_ERR) {       \
+            return NULL;                                                       \
+        }                                                                      \
+        type_* first = name_##_storage(self) + self->vec.size;                 \
+        self->vec.size += count;                                               \
+        return first;                                                          \
+    }                                                                          \
+    static inline int name_##_insert_range(                                    \
+        name_* self, size_t index, const type_* values, size_t count) {        \
+        if (index > self->vec.size) {                                          \
+            return LIBV_ERR;                                                   \
+        }                                                                      \
+        if (count == 0) {                                                      \
+            return LIBV_OK;                                                    \
+        }                                                                      \
+        if (name_##_reserve(self, self->vec.size + count) == LIBV_ERR) {       \
+            return LIBV_ERR;                                                   \
+        }                                                                      \
+        type_* data = name_##_storage(self);                                   \
+        memmove(data + index + count, data + index,                            \
+                (self->vec.size - index) * sizeof(type_));                     \
+        memcpy(data + index, values, count * sizeof(type_));                   \
+        self->vec.size += count;                                               \
+        return LIBV_OK;                                                        \
+    }                                                                          \
+    static inline int name_##_append(name_* self, const name_* other) {        \
+        /* other may be self, so its data is read after reserving */           \
+        if (other->vec.size == 0) {                                            \
+            return LIBV_OK;                                                    \
+        }                                                                      \
+        size_t count = other->vec.size;                                        \
+        if (name_##_reserve(self, self->vec.size + count) == LIBV_ERR) {       \
+            return LIBV_ERR;                                                   \
+        }                                                                      \
+        memcpy(name_##_storage(self) + self->vec.size, name_##_storage(other), \
+               count * sizeof(type_));                                         \
+        self->vec.size += count;                                               \
+        return LIBV_OK;                                                        \
+    }                                                                          \
+    static inline int name_##_copy(name_* self, const name_* other) {          \
+        self->vec.size = 0;                                                    \
+        return name_##_append(self, other);                                    \
+    }                                                                          \
+    static inline size_t name_##_index_of(const name_* self,                   \
+                                          const type_* needle) {               \
+        return vec_raw_bitwise_index_of((const char*)name_##_storage(self),    \
+                                        self->vec.size, needle,                \
+                                        sizeof(type_));                        \
+    }                                                                          \
+    static inline const type_* name_##_find(const name_* self,                 \
+                                            const type_* needle) {             \
+        size_t index = name_##_index_of(self, needle);                         \
+        if (index == VEC_NPOS) {                                               \
+            return NULL;                                                       \
+        }                                                                      \
+        return name_##_storage(self) + index;                                  \
+    }                                                                          \
+    static inline bool name_##_contains(const name_* self,                     \
+                                        const type_* needle) {                 \
+        return name_##_index_of(self, needle) != VEC_NPOS;                     \
+    }                                                                          \
+    static inline size_t name_##_count(const name_* self,                      \
+                                       const type_* needle) {                  \
+        return vec_raw_bitwise_count((const char*)name_##_storage(self),       \
+                                     self->vec.size, needle, sizeof(type_));   \
+    }                                                                          \
+    static inline const type_* name_##_iter_get(const name_##_iter* self) {    \
+        /* vec is the first member of name_ */                                 \
+        return name_##_get_at((const name_*)self->it.vec, self->it.position);  \
+    }                                                                          \
+    static inline type_* name_##_iter_get_mut(const name_##_iter* self) {      \
+        return name_##_get_at_mut((name_*)self->it.vec, self->it.position);    \
+    }
+
+// a vec whose elements are copied through policy_, one call per element
+#define VEC_DECLARE(name_, policy_, type_)                                     \
+    LIBV_BEGIN                                                                 \
+    typedef struct {                                                           \
+        vec_raw vec;                                                           \
+    } name_;                                                                   \
+    VEC_DECLARE_COMMON_(name_, policy_, type_)                                 \
+    VEC_DECLARE_STORAGE_(name_, policy_, type_)                                \
+    VEC_DECLARE_GENERIC_(name_, policy_, type_)                                \
+    LIBV_END                                                                   \
+    /* Force a semicolon. */ struct name_##_needstrailingsemicolon_ { int x; }
+
+// the same interface for trivially copyable types, policy_ must copy with
+// memcpy, compare with memcmp and have no dtor. elements are assigned
+// directly with a constant stride, append, insert_range and copy are a single
+// memcpy, and the searches use the bitwise kernels.
+#define VEC_DECLARE_TRIVIAL(name_, policy_, type_)                             \
+    LIBV_BEGIN                                                                 \
+    typedef struct {                                                           \
+        vec_raw vec;                                                           \
+    } name_;                                                                   \
+    VEC_DECLARE_COMMON_(name_, policy_, type_)                                 \
+    VEC_DECLARE_STORAGE_(name_, policy_, type_)                                \
+    VEC_DECLARE_TRIVIAL_(name_, policy_, type_)                                \
     LIBV_END                                                                   \
     /* Force a semicolon. */ struct name_##_needstrailingsemicolon_ { int x; }
 
 #define VEC_DECLARE_DEFAULT(name_, type_)                                      \
     VEC_DECLARE_DEFAULT_POLICY_(name_##_policy, type_)                         \
-    VEC_DECLARE(name_, name_##_policy, type_)
+    VEC_DECLARE_TRIVIAL(name_, name_##_policy, type_)
+
+// a vec whose storage starts on an align_ boundary, align_ must be a power of
+// two. elements stay sizeof(type_) apart.
+#define VEC_DECLARE_DEFAULT_ALIGNED(name_, type_, align_)                      \
+    VEC_DECLARE_ALIGNED_POLICY_(name_##_policy, type_, align_)                 \
+    VEC_DECLARE_TRIVIAL(name_, name_##_policy, type_)
+
+// storage on a cache line boundary, eg. for vectorized scans
+#define VEC_DECLARE_CACHE_ALIGNED(name_, type_)                                \
+    VEC_DECLARE_DEFAULT_ALIGNED(name_, type_, LIBV_CACHE_LINE_SIZE)
+
+// a vec that keeps up to n_ elements inside the struct and only allocates
+// once it grows past them. same interface as VEC_DECLARE_DEFAULT.
+#define VEC_DECLARE_INLINE(name_, type_, n_)                                   \
+    VEC_DECLARE_DEFAULT_POLICY_(name_##_policy, type_)                         \
+    LIBV_BEGIN                                                                 \
+    typedef struct {                                                           \
+        vec_raw vec;                                                           \
+        type_ buffer[n_];                                                      \
+    } name_;                                                                   \
+    VEC_DECLARE_COMMON_(name_, name_##_policy, type_)                          \
+    VEC_DECLARE_INLINE_STORAGE_(name_, name_##_policy, type_, n_)              \
+    VEC_DECLARE_TRIVIAL_(name_, name_##_policy, type_)                         \
+    LIBV_END                                                                   \
+    /* Force a semicolon. */ struct name_##_needstrailingsemicolon_ { int x; }
 
 LIBV_END
 
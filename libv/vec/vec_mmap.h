@@ -0,0 +1,312 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2026, vincer2040
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// vec_mmap
+// a vec whose storage is a memory mapped file. the file starts with a small
+// header recording the element size and the number of elements, followed by
+// the elements themselves, so reopening a file maps it straight back in with
+// no load step. growing extends the file with ftruncate and the mapping with
+// mremap. elements must be plain data, they are written to disk as they are.
+
+#ifndef __LIBV_VEC_MMAP_H__
+
+#define __LIBV_VEC_MMAP_H__
+
+#include "libv/base/base.h"
+#include "libv/vec/vec.h"
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// mremap is only declared for _GNU_SOURCE, which has to be defined before the
+// first system header, eg. -D_GNU_SOURCE. without it every grow on linux
+// would map the file again from scratch, so that is an error rather than a
+// silent fallback. other platforms have no mremap and always remap.
+#if defined(__linux__) && !defined(MREMAP_MAYMOVE)
+#error "vec_mmap.h needs _GNU_SOURCE defined before any system header"
+#endif // __linux__
+
+LIBV_BEGIN
+
+#define VEC_MMAP_MAGIC "libv_vec"
+
+// the first bytes of the file
+typedef struct {
+    char magic[8];
+    uint64_t element_size;
+    uint64_t size;
+} vec_mmap_header;
+
+typedef struct {
+    // MAP_POPULATE, fault the whole file in on open instead of on first touch
+    bool populate;
+    // passed to madvise for the whole mapping, eg. MADV_SEQUENTIAL for a log
+    // that is scanned front to back. zero is MADV_NORMAL.
+    int advice;
+    // elements room is made for when the file is created
+    size_t initial_capacity;
+} vec_mmap_options;
+
+typedef struct {
+    int fd;
+    char* base;    // start of the mapping, the header lives here
+    size_t length; // bytes mapped, a multiple of the page size
+    vec_mmap_options options;
+} vec_mmap_file;
+
+static inline vec_mmap_file vec_mmap_file_new(void) {
+    return (vec_mmap_file){-1, NULL, 0, {0}};
+}
+
+// bytes in front of the first element. a cache line, or more if the elements
+// need it, so the elements are as aligned as the page aligned mapping allows.
+static inline size_t vec_mmap_header_size(const vec_policy* policy) {
+    return policy->obj->align > LIBV_CACHE_LINE_SIZE ? policy->obj->align
+                                                     : LIBV_CACHE_LINE_SIZE;
+}
+
+static inline size_t vec_mmap_round_up(size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) & ~(page - 1);
+}
+
+static inline void vec_mmap_advise(vec_mmap_file* file) {
+    if (file->options.advice) {
+        madvise(file->base, file->length, file->options.advice);
+    }
+}
+
+// maps the file at path into vec, creating it if it does not exist. fails if
+// the file was not written by vec_mmap or holds elements of another size.
+// options may be NULL. on failure vec and file are left empty, so closing
+// them is a no op.
+static inline int vec_mmap_raw_open(const vec_policy* policy, vec_raw* vec,
+                                    vec_mmap_file* file, const char* path,
+                                    const vec_mmap_options* options) {
+    *file = vec_mmap_file_new();
+    *vec = vec_raw_new();
+    size_t header = vec_mmap_header_size(policy);
+    size_t element = policy->obj->size;
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return LIBV_ERR;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return LIBV_ERR;
+    }
+    size_t file_size = (size_t)st.st_size;
+    bool fresh = file_size == 0;
+    if (fresh) {
+        size_t initial = options ? options->initial_capacity : 0;
+        file_size = vec_mmap_round_up(header + (initial * element));
+        if (ftruncate(fd, (off_t)file_size) != 0) {
+            close(fd);
+            return LIBV_ERR;
+        }
+    } else if (file_size < header) {
+        close(fd);
+        return LIBV_ERR;
+    }
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    if (options && options->populate) {
+        flags |= MAP_POPULATE;
+    }
+#endif // MAP_POPULATE
+    size_t length = vec_mmap_round_up(file_size);
+    char* base = mmap(NULL, length, PROT_READ | PROT_WRITE, flags, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return LIBV_ERR;
+    }
+    size_t capacity = (file_size - header) / element;
+    vec_mmap_header* h = (vec_mmap_header*)base;
+    if (fresh) {
+        memcpy(h->magic, VEC_MMAP_MAGIC, sizeof h->magic);
+        h->element_size = element;
+        h->size = 0;
+    } else if (memcmp(h->magic, VEC_MMAP_MAGIC, sizeof h->magic) != 0 ||
+               h->element_size != element || h->size > capacity) {
+        munmap(base, length);
+        close(fd);
+        return LIBV_ERR;
+    }
+    *file = (vec_mmap_file){fd, base, length, {0}};
+    if (options) {
+        file->options = *options;
+    }
+    vec_mmap_advise(file);
+    *vec = (vec_raw){base + header, h->size, capacity, NULL};
+    return LIBV_OK;
+}
+
+// extends the file and the mapping to hold capacity elements. the mapping may
+// move, which invalidates pointers into it.
+static inline int vec_mmap_raw_reserve(const vec_policy* policy, vec_raw* vec,
+                                       vec_mmap_file* file, size_t capacity) {
+    if (capacity <= vec->capacity) {
+        return LIBV_OK;
+    }
+    size_t header = vec_mmap_header_size(policy);
+    size_t length = vec_mmap_round_up(header + (capacity * policy->obj->size));
+    if (ftruncate(file->fd, (off_t)length) != 0) {
+        return LIBV_ERR;
+    }
+#ifdef MREMAP_MAYMOVE
+    char* base = mremap(file->base, file->length, length, MREMAP_MAYMOVE);
+#else
+    // without mremap the file is mapped again from scratch, the pages are
+    // still in the page cache so nothing is read back in
+    char* base =
+        mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, 0);
+    if (base != MAP_FAILED) {
+        munmap(file->base, file->length);
+    }
+#endif // MREMAP_MAYMOVE
+    if (base == MAP_FAILED) {
+        return LIBV_ERR;
+    }
+    file->base = base;
+    file->length = length;
+    vec_mmap_advise(file);
+    vec->data = base + header;
+    vec->capacity = (length - header) / policy->obj->size;
+    return LIBV_OK;
+}
+
+static inline int vec_mmap_raw_grow(const vec_policy* policy, vec_raw* vec,
+                                    vec_mmap_file* file) {
+    if (LIBV_LIKELY(vec->size < vec->capacity)) {
+        return LIBV_OK;
+    }
+    // reserve rounds up to whole pages, so small files grow a page at a time
+    return vec_mmap_raw_reserve(policy, vec, file,
+                                vec->capacity + (vec->capacity / 2) + 1);
+}
+
+// writes the size into the header and flushes the dirty pages to the file.
+// with wait unset the writeback is only scheduled.
+static inline int vec_mmap_raw_sync(const vec_policy* policy,
+                                    const vec_raw* vec, vec_mmap_file* file,
+                                    bool wait) {
+    ((vec_mmap_header*)file->base)->size = vec->size;
+    size_t used = vec_mmap_round_up(vec_mmap_header_size(policy) +
+                                    (vec->size * policy->obj->size));
+    if (msync(file->base, used, wait ? MS_SYNC : MS_ASYNC) != 0) {
+        return LIBV_ERR;
+    }
+    return LIBV_OK;
+}
+
+// syncs, trims the file down to the elements in use and unmaps it. the file
+// is closed even if syncing fails.
+static inline int vec_mmap_raw_close(const vec_policy* policy, vec_raw* vec,
+                                     vec_mmap_file* file) {
+    if (file->base == NULL) {
+        return LIBV_OK;
+    }
+    int result = vec_mmap_raw_sync(policy, vec, file, true);
+    munmap(file->base, file->length);
+    off_t used = (off_t)(vec_mmap_header_size(policy) +
+                         (vec->size * policy->obj->size));
+    if (ftruncate(file->fd, used) != 0) {
+        result = LIBV_ERR;
+    }
+    if (close(file->fd) != 0) {
+        result = LIBV_ERR;
+    }
+    *file = vec_mmap_file_new();
+    *vec = vec_raw_new();
+    return result;
+}
+
+// a vec stored in a file, the same interface as VEC_DECLARE_DEFAULT except
+// that it is opened and closed instead of freed. closing is always safe, even
+// after a failed open or on a vec from name_##_new that was never opened:
+//
+//     VEC_MMAP_DECLARE(trade_log, trade);
+//
+//     trade_log log;
+//     if (trade_log_open(&log, "trades.bin", NULL) == LIBV_ERR) { ... }
+//     trade_log_push_back(&log, &t);
+//     trade_log_close(&log);
+//
+// pointers into the vec are invalidated by anything that grows it, the
+// mapping may move.
+#define VEC_MMAP_DECLARE(name_, type_)                                         \
+    VEC_DECLARE_DEFAULT_POLICY_(name_##_policy, type_)                         \
+    LIBV_BEGIN                                                                 \
+    typedef struct {                                                           \
+        vec_raw vec;                                                           \
+        vec_mmap_file file;                                                    \
+    } name_;                                                                   \
+    /* not backed by a file yet, open or close it */                           \
+    static inline name_ name_##_new(void) {                                    \
+        return (name_){vec_raw_new(), vec_mmap_file_new()};                    \
+    }                                                                          \
+    static inline int name_##_open(name_* self, const char* path,              \
+                                   const vec_mmap_options* options) {          \
+        return vec_mmap_raw_open(&name_##_policy, &self->vec, &self->file,     \
+                                 path, options);                               \
+    }                                                                          \
+    static inline int name_##_sync(name_* self) {                              \
+        return vec_mmap_raw_sync(&name_##_policy, &self->vec, &self->file,     \
+                                 true);                                        \
+    }                                                                          \
+    static inline int name_##_sync_async(name_* self) {                        \
+        return vec_mmap_raw_sync(&name_##_policy, &self->vec, &self->file,     \
+                                 false);                                       \
+    }                                                                          \
+    static inline int name_##_close(name_* self) {                             \
+        return vec_mmap_raw_close(&name_##_policy, &self->vec, &self->file);   \
+    }                                                                          \
+    VEC_DECLARE_ELEMENTS_(name_, name_##_policy, type_)                        \
+    VEC_DECLARE_VIEW_(name_, type_)                                            \
+    static inline int name_##_grow(name_* self) {                              \
+        return vec_mmap_raw_grow(&name_##_policy, &self->vec, &self->file);    \
+    }                                                                          \
+    static inline int name_##_reserve(name_* self, size_t new_capacity) {      \
+        return vec_mmap_raw_reserve(&name_##_policy, &self->vec, &self->file,  \
+                                    new_capacity);                             \
+    }                                                                          \
+    VEC_DECLARE_TRIVIAL_(name_, name_##_policy, type_)                         \
+    LIBV_END                                                                   \
+    /* Force a semicolon. */ struct name_##_needstrailingsemicolon_ { int x; }
+
+LIBV_END
+
+#endif // __LIBV_VEC_MMAP_H__
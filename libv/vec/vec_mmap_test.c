@@ -0,0 +1,146 @@
+#include "vec_mmap.h"
+#include "libv/vtest/vtest.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+    uint64_t id;
+    double price;
+    uint32_t quantity;
+} trade;
+
+VEC_MMAP_DECLARE(trade_log, trade);
+VEC_MMAP_DECLARE(u64_log, uint64_t);
+
+static void temp_path(char* path, size_t size) {
+    snprintf(path, size, "/tmp/vec_mmap_test_XXXXXX");
+    int fd = mkstemp(path);
+    close(fd);
+    unlink(path);
+}
+
+static off_t file_size(const char* path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return -1;
+    }
+    return st.st_size;
+}
+
+TEST(vec_mmap, reopen) {
+    char path[64];
+    temp_path(path, sizeof path);
+
+    trade_log log;
+    assert_int_eq(trade_log_open(&log, path, NULL), LIBV_OK);
+    assert_true(trade_log_empty(&log));
+    for (uint64_t i = 0; i < 100000; ++i) {
+        trade t = {i, i * 0.25, (uint32_t)i * 2};
+        assert_int_eq(trade_log_push_back(&log, &t), LIBV_OK);
+    }
+    assert_uint_eq((uintptr_t)trade_log_data(&log) % LIBV_CACHE_LINE_SIZE, 0);
+    assert_int_eq(trade_log_sync(&log), LIBV_OK);
+    assert_int_eq(trade_log_close(&log), LIBV_OK);
+    assert_int_eq(file_size(path),
+                  (off_t)(LIBV_CACHE_LINE_SIZE + 100000 * sizeof(trade)));
+
+    assert_int_eq(trade_log_open(&log, path, NULL), LIBV_OK);
+    assert_uint_eq(trade_log_size(&log), 100000);
+    assert_uint_eq(trade_log_capacity(&log), 100000);
+    for (size_t i = 0; i < 100000; ++i) {
+        const trade* t = trade_log_get_at(&log, i);
+        assert_uint_eq(t->id, i);
+        assert_true(t->price == i * 0.25);
+    }
+
+    trade* t = trade_log_emplace_back(&log);
+    *t = (trade){100000, 1, 1};
+    assert_int_eq(trade_log_close(&log), LIBV_OK);
+
+    assert_int_eq(trade_log_open(&log, path, NULL), LIBV_OK);
+    assert_uint_eq(trade_log_size(&log), 100001);
+    assert_uint_eq(trade_log_back(&log)->id, 100000);
+    assert_int_eq(trade_log_close(&log), LIBV_OK);
+
+    // a file of another element type is refused
+    u64_log other;
+    assert_int_eq(u64_log_open(&other, path, NULL), LIBV_ERR);
+    unlink(path);
+}
+
+TEST(vec_mmap, vec_interface) {
+    char path[64];
+    temp_path(path, sizeof path);
+
+    vec_mmap_options options = {
+        .populate = true,
+        .advice = MADV_SEQUENTIAL,
+        .initial_capacity = 1 << 16,
+    };
+    u64_log log;
+    assert_int_eq(u64_log_open(&log, path, &options), LIBV_OK);
+    assert_true(u64_log_capacity(&log) >= 1 << 16);
+
+    uint64_t values[1000];
+    for (uint64_t i = 0; i < 1000; ++i) {
+        values[i] = i;
+    }
+    uint64_t* slots = u64_log_extend_uninit(&log, 1 << 17);
+    assert_true(slots != NULL);
+    for (size_t i = 0; i < 1 << 17; ++i) {
+        slots[i] = 1000 + i;
+    }
+    assert_int_eq(u64_log_insert_range(&log, 0, values, 1000), LIBV_OK);
+    assert_uint_eq(u64_log_size(&log), 1000 + (1 << 17));
+    assert_uint_eq(u64_log_index_of(&log, &(uint64_t){5000}), 5000);
+    assert_true(u64_log_contains(&log, &(uint64_t){999}));
+    assert_int_eq(u64_log_sync_async(&log), LIBV_OK);
+
+    assert_int_eq(u64_log_remove_range(&log, 10, 1000 + (1 << 17)), LIBV_OK);
+    assert_uint_eq(u64_log_size(&log), 10);
+    uint64_t out;
+    assert_int_eq(u64_log_pop_back(&log, &out), LIBV_OK);
+    assert_uint_eq(out, 9);
+
+    size_t n = 0;
+    for (u64_log_iter it = u64_log_iter_new(&log); u64_log_iter_get(&it);
+         u64_log_iter_next(&it)) {
+        assert_uint_eq(*u64_log_iter_get(&it), n++);
+    }
+    assert_uint_eq(n, 9);
+    assert_int_eq(u64_log_close(&log), LIBV_OK);
+    assert_int_eq(file_size(path),
+                  (off_t)(LIBV_CACHE_LINE_SIZE + 9 * sizeof(uint64_t)));
+    unlink(path);
+}
+
+TEST(vec_mmap, bad_file) {
+    char path[64];
+    temp_path(path, sizeof path);
+
+    FILE* f = fopen(path, "w");
+    for (int i = 0; i < 4096; ++i) {
+        fputc('x', f);
+    }
+    fclose(f);
+
+    // a failed open leaves the log empty and closed, whatever it held before
+    u64_log log;
+    memset(&log, 0xAB, sizeof log);
+    assert_int_eq(u64_log_open(&log, path, NULL), LIBV_ERR);
+    assert_true(u64_log_empty(&log));
+    assert_int_eq(u64_log_close(&log), LIBV_OK);
+    unlink(path);
+
+    memset(&log, 0xAB, sizeof log);
+    assert_int_eq(u64_log_open(&log, "/nonexistent/dir/log", NULL), LIBV_ERR);
+    assert_int_eq(u64_log_close(&log), LIBV_OK);
+
+    // closing a log that was never opened is a no op too
+    log = u64_log_new();
+    assert_true(u64_log_empty(&log));
+    assert_int_eq(u64_log_close(&log), LIBV_OK);
+}
+
+VTEST_MAIN()
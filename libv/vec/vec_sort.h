@@ -0,0 +1,556 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2026, vincer2040
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+// vec_sort
+// sorting and binary search for vecs, generated per element type so the
+// comparator is inlined instead of called through a pointer like qsort's.
+//
+// VEC_DECLARE_SORT        - pattern defeating quicksort, a parallel merge
+//                           sort built on it and lower_bound / upper_bound
+// VEC_DECLARE_RADIX_SORT  - a stable LSD radix sort on a 64 bit key
+
+#ifndef __LIBV_VEC_SORT_H__
+
+#define __LIBV_VEC_SORT_H__
+
+#include "libv/base/base.h"
+#include "libv/vec/vec.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+LIBV_BEGIN
+
+// below this many elements pdqsort finishes with insertion sort
+#define LIBV_VEC_SORT_INSERTION_THRESHOLD 24
+// above this many elements pdqsort picks its pivot with a ninther
+#define LIBV_VEC_SORT_NINTHER_THRESHOLD 128
+
+// vecs smaller than this are not worth splitting across threads
+#ifndef LIBV_VEC_SORT_PARALLEL_MIN
+#define LIBV_VEC_SORT_PARALLEL_MIN (64 * 1024)
+#endif // LIBV_VEC_SORT_PARALLEL_MIN
+
+// radix sort keys. signed integers and doubles are mapped so their unsigned
+// order matches their numeric order.
+static inline uint64_t vec_sort_key_i64(int64_t key) {
+    return (uint64_t)key ^ ((uint64_t)1 << 63);
+}
+
+static inline uint64_t vec_sort_key_f64(double key) {
+    uint64_t bits;
+    memcpy(&bits, &key, sizeof bits);
+    return bits & ((uint64_t)1 << 63) ? ~bits : bits | ((uint64_t)1 << 63);
+}
+
+static inline size_t vec_sort_log2(size_t n) {
+    size_t log = 0;
+    while (n >>= 1) {
+        ++log;
+    }
+    return log;
+}
+
+typedef void (*vec_sort_task_fn)(void* ctx, size_t task);
+
+typedef struct {
+    vec_sort_task_fn fn;
+    void* ctx;
+    size_t task;
+} vec_sort_task;
+
+static inline void* vec_sort_task_run(void* arg) {
+    vec_sort_task* self = arg;
+    self->fn(self->ctx, self->task);
+    return NULL;
+}
+
+// runs fn for every task in [0, num_tasks), each on its own thread. the
+// calling thread runs task 0, and a task whose thread fails to start runs
+// on the calling thread too.
+static inline void vec_sort_run_tasks(size_t num_tasks, vec_sort_task_fn fn,
+                                      void* ctx) {
+    if (num_tasks <= 1) {
+        if (num_tasks == 1) {
+            fn(ctx, 0);
+        }
+        return;
+    }
+    vec_sort_task* tasks =
+        libv_default_alloc(num_tasks * sizeof *tasks, _Alignof(vec_sort_task));
+    pthread_t* ids =
+        libv_default_alloc(num_tasks * sizeof *ids, _Alignof(pthread_t));
+    bool* started =
+        libv_default_alloc(num_tasks * sizeof *started, _Alignof(bool));
+    for (size_t i = 1; i < num_tasks; ++i) {
+        tasks[i] = (vec_sort_task){fn, ctx, i};
+        started[i] = pthread_create(&ids[i], NULL, vec_sort_task_run,
+                                    &tasks[i]) == 0;
+    }
+    fn(ctx, 0);
+    for (size_t i = 1; i < num_tasks; ++i) {
+        if (started[i]) {
+            pthread_join(ids[i], NULL);
+        } else {
+            fn(ctx, i);
+        }
+    }
+    libv_default_free(started, num_tasks * sizeof *started, _Alignof(bool));
+    libv_default_free(ids, num_tasks * sizeof *ids, _Alignof(pthread_t));
+    libv_default_free(tasks, num_tasks * sizeof *tasks,
+                      _Alignof(vec_sort_task));
+}
+
+// name_   - the prefix of the generated functions
+// vec_    - any vec type from vec.h, only its accessors are used
+// type_   - the element type of vec_
+// less_   - bool (*)(const type_* a, const type_* b), a strict weak ordering
+//
+// name_sort is an unstable in place pdqsort, O(n log n) in the worst case.
+// name_parallel_sort sorts chunks on up to threads threads and merges them
+// pairwise, using a scratch buffer the size of the vec.
+#define VEC_DECLARE_SORT(name_, vec_, type_, less_)                            \
+    LIBV_BEGIN                                                                 \
+    static inline void name_##_swap(type_* a, type_* b) {                      \
+        type_ tmp = *a;                                                        \
+        *a = *b;                                                               \
+        *b = tmp;                                                              \
+    }                                                                          \
+    static inline void name_##_sort2(type_* a, type_* b) {                     \
+        if (less_(b, a)) {                                                     \
+            name_##_swap(a, b);                                                \
+        }                                                                      \
+    }                                                                          \
+    static inline void name_##_sort3(type_* a, type_* b, type_* c) {           \
+        name_##_sort2(a, b);                                                   \
+        name_##_sort2(b, c);                                                   \
+        name_##_sort2(a, b);                                                   \
+    }                                                                          \
+    static inline void name_##_insertion_sort(type_* begin, type_* end) {      \
+        if (begin == end) {                                                    \
+            return;                                                            \
+        }                                                                      \
+        for (type_* cur = begin + 1; cur != end; ++cur) {                      \
+            type_* sift = cur;                                                 \
+            type_* sift_1 = cur - 1;                                           \
+            if (less_(sift, sift_1)) {                                         \
+                type_ tmp = *sift;                                             \
+                do {                                                           \
+                    *sift-- = *sift_1;                                         \
+                } while (sift != begin && less_(&tmp, --sift_1));              \
+                *sift = tmp;                                                   \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+    /* begin[-1] must not be greater than any element in [begin, end) */       \
+    static inline void name_##_unguarded_insertion_sort(type_* begin,          \
+                                                        type_* end) {          \
+        if (begin == end) {                                                    \
+            return;                                                            \
+        }                                                                      \
+        for (type_* cur = begin + 1; cur != end; ++cur) {                      \
+            type_* sift = cur;                                                 \
+            type_* sift_1 = cur - 1;                                           \
+            if (less_(sift, sift_1)) {                                         \
+                type_ tmp = *sift;                                             \
+                do {                                                           \
+                    *sift-- = *sift_1;                                         \
+                } while (less_(&tmp, --sift_1));                               \
+                *sift = tmp;                                                   \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+    /* gives up once more than a few elements had to move */                   \
+    static inline bool name_##_partial_insertion_sort(type_* begin,            \
+                                                      type_* end) {            \
+        if (begin == end) {                                                    \
+            return true;                                                       \
+        }                                                                      \
+        size_t limit = 0;                                                      \
+        for (type_* cur = begin + 1; cur != end; ++cur) {                      \
+            if (limit > 8) {                                                   \
+                return false;                                                  \
+            }                                                                  \
+            type_* sift = cur;                                                 \
+            type_* sift_1 = cur - 1;                                           \
+            if (less_(sift, sift_1)) {                                         \
+                type_ tmp = *sift;                                             \
+                do {                                                           \
+                    *sift-- = *sift_1;                                         \
+                } while (sift != begin && less_(&tmp, --sift_1));              \
+                *sift = tmp;                                                   \
+                limit += (size_t)(cur - sift);                                 \
+            }                                                                  \
+        }                                                                      \
+        return true;                                                           \
+    }                                                                          \
+    static inline void name_##_sift_down(type_* data, size_t n, size_t i) {    \
+        type_ tmp = data[i];                                                   \
+        for (size_t child; (child = 2 * i + 1) < n; i = child) {               \
+            if (child + 1 < n && less_(&data[child], &data[child + 1])) {      \
+                child++;                                                       \
+            }                                                                  \
+            if (!less_(&tmp, &data[child])) {                                  \
+                break;                                                         \
+            }                                                                  \
+            data[i] = data[child];                                             \
+        }                                                                      \
+        data[i] = tmp;                                                         \
+    }                                                                          \
+    static inline void name_##_heap_sort(type_* begin, type_* end) {           \
+        size_t n = (size_t)(end - begin);                                      \
+        for (size_t i = n / 2; i-- > 0;) {                                     \
+            name_##_sift_down(begin, n, i);                                    \
+        }                                                                      \
+        for (size_t i = n; i-- > 1;) {                                         \
+            name_##_swap(begin, begin + i);                                    \
+            name_##_sift_down(begin, i, 0);                                    \
+        }                                                                      \
+    }                                                                          \
+    /* partitions around *begin, elements equal to the pivot go right. */      \
+    /* reports whether the range was already partitioned. */                   \
+    static inline type_* name_##_partition_right(type_* begin, type_* end,     \
+                                                 bool* already_partitioned) {  \
+        type_ pivot = *begin;                                                  \
+        type_* first = begin;                                                  \
+        type_* last = end;                                                     \
+        while (less_(++first, &pivot)) {                                       \
+        }                                                                      \
+        if (first - 1 == begin) {                                              \
+            while (first < last && !less_(--last, &pivot)) {                   \
+            }                                                                  \
+        } else {                                                               \
+            while (!less_(--last, &pivot)) {                                   \
+            }                                                                  \
+        }                                                                      \
+        *already_partitioned = first >= last;                                  \
+        while (first < last) {                                                 \
+            name_##_swap(first, last);                                         \
+            while (less_(++first, &pivot)) {                                   \
+            }                                                                  \
+            while (!less_(--last, &pivot)) {                                   \
+            }                                                                  \
+        }                                                                      \
+        type_* pivot_pos = first - 1;                                          \
+        *begin = *pivot_pos;                                                   \
+        *pivot_pos = pivot;                                                    \
+        return pivot_pos;                                                      \
+    }                                                                          \
+    /* the same with equal elements going left, used once the pivot is */      \
+    /* known to equal the element before the range */                          \
+    static inline type_* name_##_partition_left(type_* begin, type_* end) {    \
+        type_ pivot = *begin;                                                  \
+        type_* first = begin;                                                  \
+        type_* last = end;                                                     \
+        while (less_(&pivot, --last)) {                                        \
+        }                                                                      \
+        if (last + 1 == end) {                                                 \
+            while (first < last && !less_(&pivot, ++first)) {                  \
+            }                                                                  \
+        } else {                                                               \
+            while (!less_(&pivot, ++first)) {                                  \
+            }                                                                  \
+        }                                                                      \
+        while (first < last) {                                                 \
+            name_##_swap(first, last);                                         \
+            while (less_(&pivot, --last)) {                                    \
+            }                                                                  \
+            while (!less_(&pivot, ++first)) {                                  \
+            }                                                                  \
+        }                                                                      \
+        *begin = *last;                                                        \
+        *last = pivot;                                                         \
+        return last;                                                           \
+    }                                                                          \
+    /* breaks up patterns that produced an unbalanced partition */             \
+    static inline void name_##_shuffle(type_* begin, type_* pivot_pos,         \
+                                       type_* end) {                           \
+        size_t l_size = (size_t)(pivot_pos - begin);                           \
+        size_t r_size = (size_t)(end - (pivot_pos + 1));                       \
+        if (l_size >= LIBV_VEC_SORT_INSERTION_THRESHOLD) {                     \
+            name_##_swap(begin, begin + l_size / 4);                           \
+            name_##_swap(pivot_pos - 1, pivot_pos - l_size / 4);               \
+            if (l_size > LIBV_VEC_SORT_NINTHER_THRESHOLD) {                    \
+                name_##_swap(begin + 1, begin + (l_size / 4 + 1));             \
+                name_##_swap(begin + 2, begin + (l_size / 4 + 2));             \
+                name_##_swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));     \
+                name_##_swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));     \
+            }                                                                  \
+        }                                                                      \
+        if (r_size >= LIBV_VEC_SORT_INSERTION_THRESHOLD) {                     \
+            name_##_swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));         \
+            name_##_swap(end - 1, end - r_size / 4);                           \
+            if (r_size > LIBV_VEC_SORT_NINTHER_THRESHOLD) {                    \
+                name_##_swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));     \
+                name_##_swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));     \
+                name_##_swap(end - 2, end - (1 + r_size / 4));                 \
+                name_##_swap(end - 3, end - (2 + r_size / 4));                 \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+    static void name_##_pdqsort(type_* begin, type_* end, size_t bad_allowed,  \
+                                bool leftmost) {                               \
+        while (true) {                                                         \
+            size_t size = (size_t)(end - begin);                               \
+            if (size < LIBV_VEC_SORT_INSERTION_THRESHOLD) {                    \
+                if (leftmost) {                                                \
+                    name_##_insertion_sort(begin, end);                        \
+                } else {                                                       \
+                    name_##_unguarded_insertion_sort(begin, end);              \
+                }                                                              \
+                return;                                                        \
+            }                                                                  \
+            size_t half = size / 2;                                            \
+            if (size > LIBV_VEC_SORT_NINTHER_THRESHOLD) {                      \
+                name_##_sort3(begin, begin + half, end - 1);                   \
+                name_##_sort3(begin + 1, begin + (half - 1), end - 2);         \
+                name_##_sort3(begin + 2, begin + (half + 1), end - 3);         \
+                name_##_sort3(begin + (half - 1), begin + half,                \
+                              begin + (half + 1));                             \
+                name_##_swap(begin, begin + half);                             \
+            } else {                                                           \
+                name_##_sort3(begin + half, begin, end - 1);                   \
+            }                                                                  \
+            /* a pivot equal to its left neighbour means many duplicates, */   \
+            /* put them all on the left and never look at them again */        \
+            if (!leftmost && !less_(begin - 1, begin)) {                       \
+                begin = name_##_partition_left(begin, end) + 1;                \
+                continue;                                                      \
+            }                                                                  \
+            bool already_partitioned;                                          \
+            type_* pivot_pos =                                                 \
+                name_##_partition_right(begin, end, &already_partitioned);     \
+            size_t l_size = (size_t)(pivot_pos - begin);                       \
+            size_t r_size = (size_t)(end - (pivot_pos + 1));                   \
+            if (l_size < size / 8 || r_size < size / 8) {                      \
+                if (--bad_allowed == 0) {                                      \
+                    name_##_heap_sort(begin, end);                             \
+                    return;                                                    \
+                }                                                              \
+                name_##_shuffle(begin, pivot_pos, end);                        \
+            } else if (already_partitioned &&                                  \
+                       name_##_partial_insertion_sort(begin, pivot_pos) &&     \
+                       name_##_partial_insertion_sort(pivot_pos + 1, end)) {   \
+                return;                                                        \
+            }                                                                  \
+            name_##_pdqsort(begin, pivot_pos, bad_allowed, leftmost);          \
+            begin = pivot_pos + 1;                                             \
+            leftmost = false;                                                  \
+        }                                                                      \
+    }                                                                          \
+    static inline void name_##_sort_range(type_* data, size_t size) {          \
+        if (size < 2) {                                                        \
+            return;                                                            \
+        }                                                                      \
+        name_##_pdqsort(data, data + size, vec_sort_log2(size), true);         \
+    }                                                                          \
+    static inline void name_##_sort(vec_* self) {                              \
+        name_##_sort_range(vec_##_storage(self), vec_##_size(self));           \
+    }                                                                          \
+    static inline void name_##_merge(const type_* a, size_t a_size,            \
+                                     const type_* b, size_t b_size,            \
+                                     type_* out) {                             \
+        const type_* a_end = a + a_size;                                       \
+        const type_* b_end = b + b_size;                                       \
+        while (a != a_end && b != b_end) {                                     \
+            if (less_(b, a)) {                                                 \
+                *out++ = *b++;                                                 \
+            } else {                                                           \
+                *out++ = *a++;                                                 \
+            }                                                                  \
+        }                                                                      \
+        memcpy(out, a, (size_t)(a_end - a) * sizeof(type_));                   \
+        out += a_end - a;                                                      \
+        memcpy(out, b, (size_t)(b_end - b) * sizeof(type_));                   \
+    }                                                                          \
+    typedef struct {                                                           \
+        type_* src;                                                            \
+        type_* dst;                                                            \
+        size_t* bounds;                                                        \
+        size_t runs;                                                           \
+    } name_##_merge_ctx;                                                       \
+    static inline void name_##_sort_run(void* arg, size_t task) {              \
+        name_##_merge_ctx* ctx = arg;                                          \
+        size_t start = ctx->bounds[task];                                      \
+        name_##_sort_range(ctx->src + start, ctx->bounds[task + 1] - start);   \
+    }                                                                          \
+    /* merges runs 2 * task and 2 * task + 1 from src into dst */              \
+    static inline void name_##_merge_runs(void* arg, size_t task) {            \
+        name_##_merge_ctx* ctx = arg;                                          \
+        size_t start = ctx->bounds[2 * task];                                  \
+        size_t mid = ctx->bounds[2 * task + 1];                                \
+        size_t end = 2 * task + 2 <= ctx->runs ? ctx->bounds[2 * task + 2]     \
+                                               : mid;                          \
+        name_##_merge(ctx->src + start, mid - start, ctx->src + mid,           \
+                      end - mid, ctx->dst + start);                            \
+    }                                                                          \
+    static inline void name_##_parallel_sort(vec_* self, size_t threads) {     \
+        size_t size = vec_##_size(self);                                       \
+        if (threads <= 1 || size < LIBV_VEC_SORT_PARALLEL_MIN) {               \
+            name_##_sort(self);                                                \
+            return;                                                            \
+        }                                                                      \
+        if (threads > size / (LIBV_VEC_SORT_PARALLEL_MIN / 2)) {               \
+            threads = size / (LIBV_VEC_SORT_PARALLEL_MIN / 2);                 \
+        }                                                                      \
+        name_##_merge_ctx ctx = {                                              \
+            .src = vec_##_storage(self),                                       \
+            .dst = libv_default_alloc(size * sizeof(type_), _Alignof(type_)),  \
+            .bounds = libv_default_alloc((threads + 1) * sizeof(size_t),       \
+                                         _Alignof(size_t)),                    \
+            .runs = threads,                                                   \
+        };                                                                     \
+        type_* scratch = ctx.dst;                                              \
+        for (size_t i = 0; i <= threads; ++i) {                                \
+            ctx.bounds[i] = size / threads * i;                                \
+        }                                                                      \
+        ctx.bounds[threads] = size;                                            \
+        vec_sort_run_tasks(threads, name_##_sort_run, &ctx);                   \
+        while (ctx.runs > 1) {                                                 \
+            size_t merges = (ctx.runs + 1) / 2;                                \
+            vec_sort_run_tasks(merges, name_##_merge_runs, &ctx);              \
+            for (size_t i = 0; i < merges; ++i) {                              \
+                ctx.bounds[i] = ctx.bounds[2 * i];                             \
+            }                                                                  \
+            ctx.bounds[merges] = size;                                         \
+            ctx.runs = merges;                                                 \
+            type_* tmp = ctx.src;                                              \
+            ctx.src = ctx.dst;                                                 \
+            ctx.dst = tmp;                                                     \
+        }                                                                      \
+        if (ctx.src != vec_##_storage(self)) {                                 \
+            memcpy(vec_##_storage(self), ctx.src, size * sizeof(type_));       \
+        }                                                                      \
+        libv_default_free(ctx.bounds, (threads + 1) * sizeof(size_t),          \
+                          _Alignof(size_t));                                   \
+        libv_default_free(scratch, size * sizeof(type_), _Alignof(type_));     \
+    }                                                                          \
+    /* the first index whose element is not less than key, the vec must be */  \
+    /* sorted by less_ */                                                      \
+    static inline size_t name_##_lower_bound(const vec_* self,                 \
+                                             const type_* key) {               \
+        const type_* data = vec_##_data(self);                                 \
+        size_t first = 0;                                                      \
+        size_t count = vec_##_size(self);                                      \
+        while (count > 0) {                                                    \
+            size_t step = count / 2;                                           \
+            if (less_(&data[first + step], key)) {                             \
+                first += step + 1;                                             \
+                count -= step + 1;                                             \
+            } else {                                                           \
+                count = step;                                                  \
+            }                                                                  \
+        }                                                                      \
+        return first;                                                          \
+    }                                                                          \
+    /* the first index whose element is greater than key */                    \
+    static inline size_t name_##_upper_bound(const vec_* self,                 \
+                                             const type_* key) {               \
+        const type_* data = vec_##_data(self);                                 \
+        size_t first = 0;                                                      \
+        size_t count = vec_##_size(self);                                      \
+        while (count > 0) {                                                    \
+            size_t step = count / 2;                                           \
+            if (!less_(key, &data[first + step])) {                            \
+                first += step + 1;                                             \
+                count -= step + 1;                                             \
+            } else {                                                           \
+                count = step;                                                  \
+            }                                                                  \
+        }                                                                      \
+        return first;                                                          \
+    }                                                                          \
+    LIBV_END                                                                   \
+    /* Force a semicolon. */ struct name_##_sort_needstrailingsemicolon_ {     \
+        int x;                                                                 \
+    }
+
+// name_   - the prefix of the generated function
+// vec_    - any vec type from vec.h, only its accessors are used
+// type_   - the element type of vec_
+// key_    - uint64_t (*)(const type_*), see vec_sort_key_i64 and
+//           vec_sort_key_f64 for signed and floating point keys
+//
+// name_radix_sort is stable and makes one pass per byte of the key, skipping
+// bytes that are the same in every key, so 32 bit keys cost four passes.
+#define VEC_DECLARE_RADIX_SORT(name_, vec_, type_, key_)                       \
+    LIBV_BEGIN                                                                 \
+    static inline void name_##_radix_sort(vec_* self) {                        \
+        size_t size = vec_##_size(self);                                       \
+        if (size < 2) {                                                        \
+            return;                                                            \
+        }                                                                      \
+        type_* src = vec_##_storage(self);                                     \
+        type_* dst =                                                           \
+            libv_default_alloc(size * sizeof(type_), _Alignof(type_));         \
+        type_* scratch = dst;                                                  \
+        /* every histogram is built in one pass over the keys */               \
+        size_t counts[sizeof(uint64_t)][256] = {{0}};                          \
+        for (size_t i = 0; i < size; ++i) {                                    \
+            uint64_t key = key_(&src[i]);                                      \
+            for (size_t byte = 0; byte < sizeof(uint64_t); ++byte) {           \
+                counts[byte][(key >> (byte * 8)) & 0xff]++;                    \
+            }                                                                  \
+        }                                                                      \
+        for (size_t byte = 0; byte < sizeof(uint64_t); ++byte) {               \
+            size_t* count = counts[byte];                                      \
+            uint64_t digit = (key_(&src[0]) >> (byte * 8)) & 0xff;             \
+            if (count[digit] == size) {                                        \
+                continue;                                                      \
+            }                                                                  \
+            size_t offset = 0;                                                 \
+            for (size_t d = 0; d < 256; ++d) {                                 \
+                size_t c = count[d];                                           \
+                count[d] = offset;                                             \
+                offset += c;                                                   \
+            }                                                                  \
+            for (size_t i = 0; i < size; ++i) {                                \
+                dst[count[(key_(&src[i]) >> (byte * 8)) & 0xff]++] = src[i];   \
+            }                                                                  \
+            type_* tmp = src;                                                  \
+            src = dst;                                                         \
+            dst = tmp;                                                         \
+        }                                                                      \
+        if (src != vec_##_storage(self)) {                                     \
+            memcpy(vec_##_storage(self), src, size * sizeof(type_));           \
+        }                                                                      \
+        libv_default_free(scratch, size * sizeof(type_), _Alignof(type_));     \
+    }                                                                          \
+    LIBV_END                                                                   \
+    /* Force a semicolon. */ struct name_##_radix_needstrailingsemicolon_ {    \
+        int x;                                                                 \
+    }
+
+LIBV_END
+
+#endif // __LIBV_VEC_SORT_H__
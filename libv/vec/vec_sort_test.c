@@ -0,0 +1,197 @@
+#include "libv/vtest/vtest.h"
+#include "vec_sort.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+VEC_DECLARE_DEFAULT(int_vec, int);
+
+static inline bool int_less(const int* a, const int* b) { return *a < *b; }
+
+VEC_DECLARE_SORT(int_vec, int_vec, int, int_less);
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15;
+
+static uint64_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static int int_cmp(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// sorts a copy with qsort and compares
+static bool sorts_like_qsort(int_vec* v) {
+    size_t size = int_vec_size(v);
+    if (size == 0) {
+        int_vec_sort(v);
+        return true;
+    }
+    int* expected = malloc(size * sizeof(int));
+    memcpy(expected, int_vec_data(v), size * sizeof(int));
+    qsort(expected, size, sizeof(int), int_cmp);
+    int_vec_sort(v);
+    bool ok = memcmp(expected, int_vec_data(v), size * sizeof(int)) == 0;
+    free(expected);
+    return ok;
+}
+
+TEST(vec_sort, patterns) {
+    size_t sizes[] = {0, 1, 2, 23, 24, 25, 128, 129, 1000, 100000};
+    for (size_t s = 0; s < array_size(sizes); ++s) {
+        size_t size = sizes[s];
+        for (int pattern = 0; pattern < 6; ++pattern) {
+            int_vec v = int_vec_new();
+            for (size_t i = 0; i < size; ++i) {
+                int x;
+                switch (pattern) {
+                case 0: x = (int)rng(); break;
+                case 1: x = (int)i; break;
+                case 2: x = (int)(size - i); break;
+                case 3: x = 7; break;
+                case 4: x = (int)(i % 16); break;
+                default: x = (int)(rng() % 4); break;
+                }
+                assert_int_eq(int_vec_push_back(&v, &x), LIBV_OK);
+            }
+            assert_true(sorts_like_qsort(&v));
+            int_vec_free(&v);
+        }
+    }
+}
+
+TEST(vec_sort, bounds) {
+    int_vec v = int_vec_new();
+    int values[] = {1, 3, 3, 3, 5, 8};
+    assert_int_eq(int_vec_insert_range(&v, 0, values, 6), LIBV_OK);
+
+    int key = 3;
+    assert_uint_eq(int_vec_lower_bound(&v, &key), 1);
+    assert_uint_eq(int_vec_upper_bound(&v, &key), 4);
+    key = 0;
+    assert_uint_eq(int_vec_lower_bound(&v, &key), 0);
+    assert_uint_eq(int_vec_upper_bound(&v, &key), 0);
+    key = 6;
+    assert_uint_eq(int_vec_lower_bound(&v, &key), 5);
+    assert_uint_eq(int_vec_upper_bound(&v, &key), 5);
+    key = 9;
+    assert_uint_eq(int_vec_lower_bound(&v, &key), 6);
+
+    int_vec_free(&v);
+}
+
+TEST(vec_sort, parallel) {
+    int_vec v = int_vec_new();
+    for (size_t i = 0; i < 500000; ++i) {
+        int x = (int)(rng() % 100000);
+        assert_int_eq(int_vec_push_back(&v, &x), LIBV_OK);
+    }
+    int_vec expected = int_vec_new();
+    assert_int_eq(int_vec_copy(&expected, &v), LIBV_OK);
+    int_vec_sort(&expected);
+
+    int_vec_parallel_sort(&v, 5);
+    assert_mem_eq(int_vec_data(&v), int_vec_data(&expected),
+                  500000 * sizeof(int));
+
+    int_vec_free(&v);
+    int_vec_free(&expected);
+}
+
+typedef struct {
+    int64_t key;
+    size_t index;
+} record;
+
+VEC_DECLARE_DEFAULT(record_vec, record);
+
+static inline uint64_t record_key(const record* r) {
+    return vec_sort_key_i64(r->key);
+}
+
+VEC_DECLARE_RADIX_SORT(record_vec, record_vec, record, record_key);
+
+TEST(vec_sort, radix_stable) {
+    record_vec v = record_vec_new();
+    for (size_t i = 0; i < 100000; ++i) {
+        record r = {(int64_t)(rng() % 2000) - 1000, i};
+        assert_int_eq(record_vec_push_back(&v, &r), LIBV_OK);
+    }
+    record_vec_radix_sort(&v);
+    for (size_t i = 1; i < 100000; ++i) {
+        const record* a = record_vec_get_at(&v, i - 1);
+        const record* b = record_vec_get_at(&v, i);
+        assert_true(a->key <= b->key);
+        if (a->key == b->key) {
+            assert_true(a->index < b->index);
+        }
+    }
+    record_vec_free(&v);
+}
+
+VEC_DECLARE_DEFAULT(double_vec, double);
+
+static inline uint64_t double_key(const double* d) {
+    return vec_sort_key_f64(*d);
+}
+
+VEC_DECLARE_RADIX_SORT(double_vec, double_vec, double, double_key);
+
+TEST(vec_sort, radix_double) {
+    double_vec v = double_vec_new();
+    double values[] = {3.5, -0.0, -2.25, 1e300, -1e300, 0.0, 2.0, -7.0};
+    assert_int_eq(double_vec_insert_range(&v, 0, values, 8), LIBV_OK);
+    double_vec_radix_sort(&v);
+    for (size_t i = 1; i < 8; ++i) {
+        assert_true(*double_vec_get_at(&v, i - 1) <= *double_vec_get_at(&v, i));
+    }
+    assert_true(*double_vec_front(&v) == -1e300);
+    double_vec_free(&v);
+}
+
+VEC_DECLARE_INLINE(small_vec, int, 8);
+VEC_DECLARE_SORT(small_vec, small_vec, int, int_less);
+
+static inline uint64_t int_key(const int* x) { return vec_sort_key_i64(*x); }
+
+VEC_DECLARE_RADIX_SORT(small_vec, small_vec, int, int_key);
+
+TEST(vec_sort, inline) {
+    size_t sizes[] = {5, 8, 9, 100};
+    for (size_t s = 0; s < array_size(sizes); ++s) {
+        small_vec a = small_vec_new();
+        small_vec b = small_vec_new();
+        for (size_t i = 0; i < sizes[s]; ++i) {
+            int x = (int)(rng() % 200) - 100;
+            small_vec_push_back(&a, &x);
+            small_vec_push_back(&b, &x);
+        }
+        assert_true((a.vec.data == NULL) == (sizes[s] <= 8));
+
+        small_vec_sort(&a);
+        small_vec_radix_sort(&b);
+        for (size_t i = 1; i < sizes[s]; ++i) {
+            assert_true(*small_vec_get_at(&a, i - 1) <=
+                        *small_vec_get_at(&a, i));
+        }
+        assert_mem_eq(small_vec_data(&a), small_vec_data(&b),
+                      sizes[s] * sizeof(int));
+
+        int key = *small_vec_get_at(&a, sizes[s] / 2);
+        size_t lower = small_vec_lower_bound(&a, &key);
+        assert_int_eq(*small_vec_get_at(&a, lower), key);
+        assert_true(small_vec_upper_bound(&a, &key) > lower);
+
+        small_vec_parallel_sort(&b, 4);
+        assert_mem_eq(small_vec_data(&a), small_vec_data(&b),
+                      sizes[s] * sizeof(int));
+        small_vec_free(&a);
+        small_vec_free(&b);
+    }
+}
+
+VTEST_MAIN()
@@ -1,5 +1,7 @@
 #include "libv/vtest/vtest.h"
 #include "vec.h"
+#include <stdint.h>
+#include <stdio.h>
 
 VEC_DECLARE_DEFAULT(int_vec, int);
 
@@ -109,4 +111,452 @@ TEST(vec, iter) {
     int_vec_free(&v);
 }
 
+TEST(vec, insert_range) {
+    int_vec v = int_vec_new();
+    int values[] = {1, 2, 3, 4, 5};
+
+    assert_int_eq(int_vec_insert_range(&v, 1, values, 5), LIBV_ERR);
+    assert_int_eq(int_vec_insert_range(&v, 0, values, 5), LIBV_OK);
+    assert_int_eq(int_vec_insert_range(&v, 2, values, 2), LIBV_OK);
+    assert_int_eq(int_vec_insert_range(&v, 7, values + 4, 1), LIBV_OK);
+
+    int expected[] = {1, 2, 1, 2, 3, 4, 5, 5};
+    assert_uint_eq(int_vec_size(&v), array_size(expected));
+    assert_mem_eq(int_vec_data(&v), expected, sizeof expected);
+
+    int_vec_free(&v);
+}
+
+TEST(vec, append_copy) {
+    int_vec a = int_vec_new();
+    int_vec b = int_vec_new();
+    for (int i = 0; i < 100; ++i) {
+        assert_int_eq(int_vec_push_back(&a, &i), LIBV_OK);
+    }
+
+    assert_int_eq(int_vec_append(&b, &a), LIBV_OK);
+    assert_int_eq(int_vec_append(&b, &b), LIBV_OK);
+    assert_uint_eq(int_vec_size(&b), 200);
+    for (int i = 0; i < 200; ++i) {
+        assert_int_eq(*int_vec_get_at(&b, i), i % 100);
+    }
+
+    assert_int_eq(int_vec_copy(&a, &b), LIBV_OK);
+    assert_uint_eq(int_vec_size(&a), 200);
+    assert_mem_eq(int_vec_data(&a), int_vec_data(&b), 200 * sizeof(int));
+
+    int_vec_free(&a);
+    int_vec_free(&b);
+}
+
+typedef struct {
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+} triple;
+
+VEC_DECLARE_DEFAULT(u8_vec, uint8_t);
+VEC_DECLARE_DEFAULT(u16_vec, uint16_t);
+VEC_DECLARE_DEFAULT(u64_vec, uint64_t);
+VEC_DECLARE_DEFAULT(triple_vec, triple);
+
+TEST(vec, search) {
+    // every size up to a few vectors, with the needle in the vector body, in
+    // the scalar tail and missing
+    for (size_t size = 0; size < 100; ++size) {
+        u8_vec v8 = u8_vec_new();
+        u16_vec v16 = u16_vec_new();
+        int_vec v32 = int_vec_new();
+        u64_vec v64 = u64_vec_new();
+        triple_vec v96 = triple_vec_new();
+        for (size_t i = 0; i < size; ++i) {
+            uint8_t x8 = (uint8_t)(i % 50);
+            uint16_t x16 = (uint16_t)(i % 50) << 8;
+            int x32 = -(int)(i % 50);
+            uint64_t x64 = ((uint64_t)(i % 50) << 32) | 7;
+            triple x96 = {1, 2, (uint32_t)(i % 50)};
+            assert_int_eq(u8_vec_push_back(&v8, &x8), LIBV_OK);
+            assert_int_eq(u16_vec_push_back(&v16, &x16), LIBV_OK);
+            assert_int_eq(int_vec_push_back(&v32, &x32), LIBV_OK);
+            assert_int_eq(u64_vec_push_back(&v64, &x64), LIBV_OK);
+            assert_int_eq(triple_vec_push_back(&v96, &x96), LIBV_OK);
+        }
+        for (size_t n = 0; n < 51; ++n) {
+            // n == 50 never occurs
+            bool present = n < size && n < 50;
+            size_t expected_index = present ? n : VEC_NPOS;
+            size_t expected_count = 0;
+            for (size_t i = 0; i < size; ++i) {
+                expected_count += i % 50 == n;
+            }
+
+            uint8_t x8 = (uint8_t)n;
+            uint16_t x16 = (uint16_t)n << 8;
+            int x32 = -(int)n;
+            uint64_t x64 = ((uint64_t)n << 32) | 7;
+            triple x96 = {1, 2, (uint32_t)n};
+            assert_uint_eq(u8_vec_index_of(&v8, &x8), expected_index);
+            assert_uint_eq(u16_vec_index_of(&v16, &x16), expected_index);
+            assert_uint_eq(int_vec_index_of(&v32, &x32), expected_index);
+            assert_uint_eq(u64_vec_index_of(&v64, &x64), expected_index);
+            assert_uint_eq(triple_vec_index_of(&v96, &x96), expected_index);
+            assert_uint_eq(u8_vec_count(&v8, &x8), expected_count);
+            assert_uint_eq(u16_vec_count(&v16, &x16), expected_count);
+            assert_uint_eq(int_vec_count(&v32, &x32), expected_count);
+            assert_uint_eq(u64_vec_count(&v64, &x64), expected_count);
+            assert_uint_eq(triple_vec_count(&v96, &x96), expected_count);
+            assert_true(int_vec_contains(&v32, &x32) == present);
+            if (present) {
+                assert_true(u64_vec_find(&v64, &x64) ==
+                            u64_vec_get_at(&v64, n));
+            } else {
+                assert_ptr_null(u64_vec_find(&v64, &x64));
+            }
+        }
+        u8_vec_free(&v8);
+        u16_vec_free(&v16);
+        int_vec_free(&v32);
+        u64_vec_free(&v64);
+        triple_vec_free(&v96);
+    }
+}
+
+static size_t tracked_copies = 0;
+
+static void tracked_copy(void* dst, const void* src) {
+    tracked_copies++;
+    memcpy(dst, src, sizeof(int));
+}
+
+static bool tracked_eq(const void* a, const void* b) {
+    return *(const int*)a == *(const int*)b;
+}
+
+static const vec_object_policy tracked_object_policy = {
+    sizeof(int), _Alignof(int), tracked_copy, tracked_eq, NULL,
+};
+
+static const libv_alloc_policy tracked_alloc_policy = {
+    libv_default_alloc,
+    NULL,
+    libv_default_realloc,
+    libv_default_free,
+};
+
+static const vec_policy tracked_policy = {
+    &tracked_alloc_policy,
+    &tracked_object_policy,
+};
+
+VEC_DECLARE(tracked_vec, tracked_policy, int);
+
+TEST(vec, generic_copies) {
+    tracked_vec a = tracked_vec_new();
+    tracked_vec b = tracked_vec_new();
+    int values[] = {1, 2, 3};
+
+    assert_int_eq(tracked_vec_insert_range(&a, 0, values, 3), LIBV_OK);
+    assert_uint_eq(tracked_copies, 3);
+    assert_int_eq(tracked_vec_append(&b, &a), LIBV_OK);
+    assert_uint_eq(tracked_copies, 6);
+    assert_int_eq(tracked_vec_copy(&a, &b), LIBV_OK);
+    assert_uint_eq(tracked_copies, 9);
+    assert_int_eq(*tracked_vec_back(&a), 3);
+
+    int x = 2;
+    assert_uint_eq(tracked_vec_index_of(&a, &x), 1);
+    assert_uint_eq(tracked_vec_count(&a, &x), 1);
+    assert_true(tracked_vec_find(&a, &x) == tracked_vec_get_at(&a, 1));
+    x = 4;
+    assert_false(tracked_vec_contains(&a, &x));
+
+    tracked_vec_free(&a);
+    tracked_vec_free(&b);
+}
+
+typedef struct {
+    size_t allocs;
+    size_t frees;
+} counting_ctx;
+
+static void* counting_alloc(void* ctx, size_t size, size_t align) {
+    ((counting_ctx*)ctx)->allocs++;
+    return libv_default_alloc(size, align);
+}
+
+static void* counting_realloc(void* ctx, void* ptr, size_t old_size,
+                              size_t new_size, size_t align) {
+    ((counting_ctx*)ctx)->allocs++;
+    return libv_default_realloc(ptr, old_size, new_size, align);
+}
+
+static void counting_free(void* ctx, void* ptr, size_t size, size_t align) {
+    ((counting_ctx*)ctx)->frees++;
+    libv_default_free(ptr, size, align);
+}
+
+TEST(vec, allocator) {
+    counting_ctx ctx = {0};
+    libv_allocator allocator = {
+        &ctx,
+        counting_alloc,
+        counting_realloc,
+        counting_free,
+    };
+
+    int_vec v = int_vec_new_in(&allocator);
+    for (int i = 0; i < 100; ++i) {
+        assert_int_eq(int_vec_push_back(&v, &i), LIBV_OK);
+    }
+    assert_true(ctx.allocs > 0);
+    assert_uint_eq(ctx.frees, 0);
+
+    int_vec_free(&v);
+    assert_uint_eq(ctx.frees, 1);
+}
+
+VEC_DECLARE_CACHE_ALIGNED(float_vec, float);
+
+typedef struct {
+    _Alignas(128) double lanes[4];
+} wide;
+
+VEC_DECLARE_DEFAULT(wide_vec, wide);
+
+TEST(vec, aligned) {
+    assert_uint_eq(float_vec_policy.obj->align, LIBV_CACHE_LINE_SIZE);
+
+    float_vec v = float_vec_new();
+    wide_vec w = wide_vec_new();
+    for (int i = 0; i < 10000; ++i) {
+        float f = (float)i;
+        assert_int_eq(float_vec_push_back(&v, &f), LIBV_OK);
+        assert_uint_eq((uintptr_t)v.vec.data % LIBV_CACHE_LINE_SIZE, 0);
+        wide x = {{i, i, i, i}};
+        assert_int_eq(wide_vec_push_back(&w, &x), LIBV_OK);
+        assert_uint_eq((uintptr_t)w.vec.data % 128, 0);
+    }
+    for (int i = 0; i < 10000; ++i) {
+        assert_true(*float_vec_get_at(&v, i) == (float)i);
+        assert_true(wide_vec_get_at(&w, i)->lanes[3] == i);
+    }
+
+    float_vec_free(&v);
+    wide_vec_free(&w);
+}
+
+VEC_DECLARE_INLINE(small_vec, int, 8);
+
+static small_vec small_vec_range(int n) {
+    small_vec v = small_vec_new();
+    for (int i = 0; i < n; ++i) {
+        small_vec_push_back(&v, &i);
+    }
+    return v;
+}
+
+TEST(vec, inline) {
+    counting_ctx ctx = {0};
+    libv_allocator allocator = {
+        &ctx,
+        counting_alloc,
+        counting_realloc,
+        counting_free,
+    };
+
+    small_vec v = small_vec_new_in(&allocator);
+    assert_uint_eq(small_vec_capacity(&v), 8);
+    for (int i = 0; i < 8; ++i) {
+        assert_int_eq(small_vec_push_back(&v, &i), LIBV_OK);
+    }
+    assert_uint_eq(ctx.allocs, 0);
+    assert_true(v.vec.data == NULL);
+    assert_true(small_vec_data(&v) == v.buffer);
+
+    int x = 8;
+    assert_int_eq(small_vec_push_back(&v, &x), LIBV_OK);
+    assert_uint_eq(ctx.allocs, 1);
+    assert_true(small_vec_data(&v) == (const int*)v.vec.data);
+    assert_uint_eq(small_vec_capacity(&v), 16);
+    for (int i = 0; i < 9; ++i) {
+        assert_int_eq(*small_vec_get_at(&v, i), i);
+    }
+
+    int values[] = {-1, -2, -3};
+    assert_int_eq(small_vec_insert_range(&v, 4, values, array_size(values)),
+                  LIBV_OK);
+    assert_uint_eq(small_vec_size(&v), 12);
+    assert_int_eq(*small_vec_get_at(&v, 5), -2);
+    assert_uint_eq(small_vec_index_of(&v, &values[2]), 6);
+    assert_int_eq(*small_vec_back(&v), 8);
+
+    for (int i = 0; i < 6; ++i) {
+        assert_int_eq(small_vec_pop_back(&v, NULL), LIBV_OK);
+    }
+    assert_int_eq(small_vec_shrink_to_size(&v), LIBV_OK);
+    assert_uint_eq(ctx.frees, 1);
+    assert_true(v.vec.data == NULL);
+    assert_uint_eq(small_vec_capacity(&v), 8);
+    int expected[] = {0, 1, 2, 3, -1, -2};
+    assert_mem_eq(small_vec_data(&v), expected, sizeof expected);
+
+    assert_int_eq(small_vec_append(&v, &v), LIBV_OK);
+    assert_uint_eq(small_vec_size(&v), 12);
+    assert_mem_eq(small_vec_data(&v) + 6, expected, sizeof expected);
+    small_vec_free(&v);
+    assert_uint_eq(ctx.frees, 2);
+
+    small_vec inline_ = small_vec_range(5);
+    small_vec spilled = small_vec_range(20);
+    assert_true(inline_.vec.data == NULL);
+    assert_true(small_vec_contains(&inline_, &(int){4}));
+    assert_false(small_vec_contains(&inline_, &(int){5}));
+    assert_uint_eq(small_vec_count(&spilled, &(int){19}), 1);
+
+    size_t n = 0;
+    for (small_vec_iter it = small_vec_iter_new(&spilled);
+         small_vec_iter_get(&it); small_vec_iter_next(&it)) {
+        assert_int_eq(*small_vec_iter_get(&it), (int)n++);
+    }
+    assert_uint_eq(n, 20);
+
+    small_vec_free(&inline_);
+    small_vec_free(&spilled);
+}
+
+typedef struct {
+    int id;
+    char name[60];
+} record;
+
+VEC_DECLARE_DEFAULT(record_vec, record);
+
+TEST(vec, mut) {
+    record_vec v = record_vec_new();
+    for (int i = 0; i < 100; ++i) {
+        record* r = record_vec_emplace_back(&v);
+        assert_true(r != NULL);
+        r->id = i;
+        snprintf(r->name, sizeof r->name, "record %d", i);
+    }
+    record* rs = record_vec_extend_uninit(&v, 50);
+    assert_true(rs == record_vec_get_at_mut(&v, 100));
+    for (int i = 0; i < 50; ++i) {
+        rs[i].id = 100 + i;
+        rs[i].name[0] = 0;
+    }
+    assert_uint_eq(record_vec_size(&v), 150);
+
+    record_vec_get_at_mut(&v, 3)->id = -3;
+    record_vec_back_mut(&v)->id = -149;
+    assert_true(record_vec_get_at_mut(&v, 150) == NULL);
+    for (record_vec_iter it = record_vec_iter_new(&v);
+         record_vec_iter_get(&it); record_vec_iter_next(&it)) {
+        record_vec_iter_get_mut(&it)->id *= 2;
+    }
+    assert_int_eq(record_vec_get_at(&v, 3)->id, -6);
+    assert_int_eq(record_vec_get_at(&v, 42)->id, 84);
+    assert_str_eq(record_vec_get_at(&v, 42)->name, "record 42");
+    assert_int_eq(record_vec_back(&v)->id, -298);
+    record_vec_free(&v);
+
+    size_t copies = tracked_copies;
+    tracked_vec t = tracked_vec_new();
+    for (int i = 0; i < 10; ++i) {
+        *tracked_vec_emplace_back(&t) = i;
+    }
+    *tracked_vec_get_at_mut(&t, 0) = 42;
+    int* ts = tracked_vec_extend_uninit(&t, 3);
+    ts[0] = ts[1] = ts[2] = 7;
+    assert_uint_eq(tracked_copies, copies);
+    assert_uint_eq(tracked_vec_count(&t, &(int){7}), 4);
+    assert_int_eq(*tracked_vec_back_mut(&t), 7);
+    assert_int_eq(*tracked_vec_get_at(&t, 0), 42);
+    tracked_vec_free(&t);
+}
+
+static bool is_even(void* ctx, const int* value) {
+    (void)ctx;
+    return *value % 2 == 0;
+}
+
+static bool is_multiple(void* ctx, const int* value) {
+    return *value % *(const int*)ctx == 0;
+}
+
+static size_t dropped = 0;
+
+static void dropped_dtor(void* value) {
+    (void)value;
+    dropped++;
+}
+
+static const vec_object_policy dropped_object_policy = {
+    sizeof(int), _Alignof(int), tracked_copy, tracked_eq, dropped_dtor,
+};
+
+static const vec_policy dropped_policy = {
+    &tracked_alloc_policy,
+    &dropped_object_policy,
+};
+
+VEC_DECLARE(dropped_vec, dropped_policy, int);
+
+TEST(vec, retain) {
+    int_vec v = int_vec_new();
+    dropped_vec d = dropped_vec_new();
+    small_vec s = small_vec_range(8);
+    for (int i = 0; i < 1000; ++i) {
+        int_vec_push_back(&v, &i);
+        dropped_vec_push_back(&d, &i);
+    }
+
+    assert_uint_eq(int_vec_retain(&v, is_even, NULL), 500);
+    assert_uint_eq(dropped_vec_retain(&d, is_even, NULL), 500);
+    assert_uint_eq(dropped, 500);
+    assert_uint_eq(small_vec_retain(&s, is_even, NULL), 4);
+    for (int i = 0; i < 500; ++i) {
+        assert_int_eq(*int_vec_get_at(&v, i), i * 2);
+        assert_int_eq(*dropped_vec_get_at(&d, i), i * 2);
+    }
+    int expected[] = {0, 2, 4, 6};
+    assert_mem_eq(small_vec_data(&s), expected, sizeof expected);
+
+    int three = 3;
+    assert_uint_eq(int_vec_remove_if(&v, is_multiple, &three), 167);
+    assert_uint_eq(dropped_vec_remove_if(&d, is_multiple, &three), 167);
+    assert_uint_eq(dropped, 667);
+    assert_uint_eq(int_vec_size(&v), 333);
+    assert_int_eq(*int_vec_get_at(&v, 0), 2);
+    assert_int_eq(*int_vec_get_at(&v, 1), 4);
+    assert_int_eq(*int_vec_get_at(&v, 2), 8);
+    assert_mem_eq(int_vec_data(&v), dropped_vec_data(&d), 333 * sizeof(int));
+
+    int x;
+    assert_int_eq(int_vec_swap_remove(&v, 0, &x), LIBV_OK);
+    assert_int_eq(x, 2);
+    assert_int_eq(*int_vec_get_at(&v, 0), 998);
+    assert_int_eq(dropped_vec_swap_remove(&d, 0, NULL), LIBV_OK);
+    assert_uint_eq(dropped, 668);
+    assert_int_eq(*dropped_vec_get_at(&d, 0), 998);
+    assert_int_eq(int_vec_swap_remove(&v, 332, NULL), LIBV_ERR);
+    assert_int_eq(int_vec_swap_remove(&v, 331, &x), LIBV_OK);
+    assert_int_eq(x, 994);
+
+    assert_int_eq(int_vec_remove_range(&v, 10, 9), LIBV_ERR);
+    assert_int_eq(int_vec_remove_range(&v, 0, 332), LIBV_ERR);
+    assert_int_eq(int_vec_remove_range(&v, 1, 330), LIBV_OK);
+    assert_uint_eq(int_vec_size(&v), 2);
+    assert_int_eq(*int_vec_get_at(&v, 1), 992);
+    assert_int_eq(dropped_vec_remove_range(&d, 1, 331), LIBV_OK);
+    assert_uint_eq(dropped, 998);
+    assert_int_eq(*dropped_vec_back(&d), 994);
+    assert_int_eq(small_vec_remove_range(&s, 1, 3), LIBV_OK);
+    assert_int_eq(*small_vec_back(&s), 6);
+
+    int_vec_free(&v);
+    dropped_vec_free(&d);
+    small_vec_free(&s);
+}
+
 int main(void) { return vtest_run_tests(); }
@@ -0,0 +1,404 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2026, vincer2040
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// vjoin
+// a radix-partitioned hash join. both inputs are scattered into partitions
+// using the high bits of their key hashes so that every partition's build
+// side fits in cache. a small vmap is built per partition and the partitions
+// are probed in parallel.
+
+#ifndef __LIBV_VJOIN_H__
+
+#define __LIBV_VJOIN_H__
+
+#include "libv/base/base.h"
+#include "libv/vec/vec.h"
+#include "libv/vmap/vmap.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+LIBV_BEGIN
+
+// the amount of build side memory (tuples, chain links and vmap slots) each
+// partition should aim for. defaults to a typical L2 size.
+#ifndef LIBV_VJOIN_PARTITION_BYTES
+#define LIBV_VJOIN_PARTITION_BYTES (256 * 1024)
+#endif // LIBV_VJOIN_PARTITION_BYTES
+
+// partitioning is done in a single pass, past this fan out the scatter
+// itself starts thrashing the TLB.
+#ifndef LIBV_VJOIN_MAX_RADIX_BITS
+#define LIBV_VJOIN_MAX_RADIX_BITS 12
+#endif // LIBV_VJOIN_MAX_RADIX_BITS
+
+#define VJOIN_NONE SIZE_MAX
+
+typedef struct {
+    size_t build;
+    size_t probe;
+} vjoin_pair;
+
+VEC_DECLARE_DEFAULT(vjoin_pair_vec, vjoin_pair);
+
+static inline uint32_t vjoin_radix_bits(size_t rows, size_t row_bytes) {
+    size_t partitions = (rows * row_bytes) / LIBV_VJOIN_PARTITION_BYTES;
+    if (partitions <= 1) {
+        return 0;
+    }
+    uint32_t bits = 64 - vmap_leading_zeros64(partitions - 1);
+    return bits > LIBV_VJOIN_MAX_RADIX_BITS ? LIBV_VJOIN_MAX_RADIX_BITS : bits;
+}
+
+// vmap indexes its slots with the low bits of the hash, so partitions are
+// chosen with the high bits to keep the two independent.
+static inline size_t vjoin_partition_of(uint64_t hash, uint32_t bits) {
+    if (bits == 0) {
+        return 0;
+    }
+    return (size_t)(hash >> (64 - bits));
+}
+
+// fills offsets (which must hold (1 << bits) + 1 entries) with the start of
+// every partition, offsets[p + 1] - offsets[p] is the size of partition p.
+static inline void vjoin_raw_histogram(const uint64_t* hashes, size_t count,
+                                       uint32_t bits, size_t* offsets) {
+    size_t partitions = (size_t)1 << bits;
+    memset(offsets, 0, (partitions + 1) * sizeof *offsets);
+    for (size_t i = 0; i < count; ++i) {
+        offsets[vjoin_partition_of(hashes[i], bits) + 1]++;
+    }
+    for (size_t p = 0; p < partitions; ++p) {
+        offsets[p + 1] += offsets[p];
+    }
+}
+
+typedef void (*vjoin_task_fn)(void* ctx, size_t worker, size_t task);
+
+typedef struct {
+    vjoin_task_fn fn;
+    void* ctx;
+    size_t worker;
+    size_t num_tasks;
+    atomic_size_t* next_task;
+} vjoin_worker;
+
+static inline void* vjoin_worker_run(void* arg) {
+    vjoin_worker* self = arg;
+    while (true) {
+        size_t task = atomic_fetch_add(self->next_task, 1);
+        if (task >= self->num_tasks) {
+            break;
+        }
+        self->fn(self->ctx, self->worker, task);
+    }
+    return NULL;
+}
+
+// runs fn once for every task in [0, num_tasks) on up to threads workers.
+// tasks are handed out one at a time so skewed partitions balance out. the
+// calling thread is always worker 0.
+static inline void vjoin_raw_parallel_for(size_t num_tasks, size_t threads,
+                                          vjoin_task_fn fn, void* ctx) {
+    atomic_size_t next_task = 0;
+    if (threads > num_tasks) {
+        threads = num_tasks;
+    }
+    if (threads <= 1) {
+        vjoin_worker self = {fn, ctx, 0, num_tasks, &next_task};
+        vjoin_worker_run(&self);
+        return;
+    }
+
+    vjoin_worker* workers =
+        libv_default_alloc(threads * sizeof *workers, _Alignof(vjoin_worker));
+    pthread_t* ids =
+        libv_default_alloc(threads * sizeof *ids, _Alignof(pthread_t));
+    size_t started = 1;
+    for (size_t i = 0; i < threads; ++i) {
+        workers[i] = (vjoin_worker){fn, ctx, i, num_tasks, &next_task};
+    }
+    for (; started < threads; ++started) {
+        // a worker that fails to start just leaves its share to the others
+        if (pthread_create(&ids[started], NULL, vjoin_worker_run,
+                           &workers[started]) != 0) {
+            break;
+        }
+    }
+    vjoin_worker_run(&workers[0]);
+    for (size_t i = 1; i < started; ++i) {
+        pthread_join(ids[i], NULL);
+    }
+
+    libv_default_free(ids, threads * sizeof *ids, _Alignof(pthread_t));
+    libv_default_free(workers, threads * sizeof *workers,
+                      _Alignof(vjoin_worker));
+}
+
+// name_##_partition_##side_ hashes every row of a vec_ of type_ with the
+// key key_fn_ extracts, and scatters them into tuples grouped by partition.
+// offsets gets the start of each partition and the returned tuples are freed
+// by the caller. build and probe only differ in their row type and key.
+#define VJOIN_DECLARE_SCATTER_(name_, side_, vec_, type_, key_, key_fn_)       \
+    static inline name_##_tuple* name_##_partition_##side_(                    \
+        const vec_* rows, uint32_t bits, size_t* offsets) {                    \
+        size_t count = vec_##_size(rows);                                      \
+        const type_* data = vec_##_data(rows);                                 \
+        size_t partitions = (size_t)1 << bits;                                 \
+        uint64_t* hashes =                                                     \
+            libv_default_alloc(count * sizeof *hashes, _Alignof(uint64_t));    \
+        for (size_t i = 0; i < count; ++i) {                                   \
+            key_ key = key_fn_(&data[i]);                                      \
+            hashes[i] = name_##_hash_key(&key);                                \
+        }                                                                      \
+        vjoin_raw_histogram(hashes, count, bits, offsets);                     \
+        size_t* cursor = libv_default_alloc(partitions * sizeof *cursor,       \
+                                            _Alignof(size_t));                 \
+        memcpy(cursor, offsets, partitions * sizeof *cursor);                  \
+        name_##_tuple* tuples = libv_default_alloc(                            \
+            count * sizeof *tuples, _Alignof(name_##_tuple));                  \
+        for (size_t i = 0; i < count; ++i) {                                   \
+            name_##_tuple* t =                                                 \
+                &tuples[cursor[vjoin_partition_of(hashes[i], bits)]++];        \
+            t->hash = hashes[i];                                               \
+            t->index = i;                                                      \
+            t->key = key_fn_(&data[i]);                                        \
+        }                                                                      \
+        libv_default_free(cursor, partitions * sizeof *cursor,                 \
+                          _Alignof(size_t));                                   \
+        libv_default_free(hashes, count * sizeof *hashes, _Alignof(uint64_t)); \
+        return tuples;                                                         \
+    }
+
+// name_        - the name of the join type
+// build_vec_   - a vec declared with VEC_DECLARE holding the build side rows
+// build_type_  - the element type of build_vec_
+// probe_vec_   - a vec declared with VEC_DECLARE holding the probe side rows
+// probe_type_  - the element type of probe_vec_
+// key_         - the join key, compared bytewise and hashed with rapidhash
+// build_key_   - key_ (*)(const build_type_*)
+// probe_key_   - key_ (*)(const probe_type_*)
+//
+// matches are emitted as vjoin_pair indices into the build and probe vecs.
+#define VJOIN_DECLARE(name_, build_vec_, build_type_, probe_vec_, probe_type_, \
+                      key_, build_key_, probe_key_)                            \
+    /* the entry is stored whole in the slot so its layout always matches */   \
+    typedef struct {                                                           \
+        key_ key;                                                              \
+        size_t value;                                                          \
+    } name_##_table_entry;                                                     \
+    VMAP_DECLARE_SET_SLOT(name_##_table, name_##_table_entry);                 \
+    VMAP_DECLARE_DEFAULT_POLICY_(name_##_table, key_, name_##_table_entry,     \
+                                 name_##_table_slot);                          \
+    VMAP_DECLARE_(name_##_table, name_##_table_policy, key_,                   \
+                  name_##_table_entry);                                        \
+    LIBV_BEGIN                                                                 \
+    typedef struct {                                                           \
+        uint64_t hash;                                                         \
+        size_t index;                                                          \
+        key_ key;                                                              \
+    } name_##_tuple;                                                           \
+    typedef struct {                                                           \
+        uint32_t bits;                                                         \
+        size_t rows;                                                           \
+        size_t* offsets;                                                       \
+        name_##_tuple* tuples;                                                 \
+        size_t* next;                                                          \
+        name_##_table* tables;                                                 \
+    } name_;                                                                   \
+    static inline name_ name_##_new(void) { return (name_){0}; }               \
+    static inline size_t name_##_num_partitions(const name_* self) {           \
+        return (size_t)1 << self->bits;                                        \
+    }                                                                          \
+    static inline void name_##_free(name_* self) {                             \
+        size_t partitions = name_##_num_partitions(self);                      \
+        if (self->tables) {                                                    \
+            for (size_t p = 0; p < partitions; ++p) {                          \
+                name_##_table_destroy(&self->tables[p]);                       \
+            }                                                                  \
+            libv_default_free(self->tables,                                    \
+                              partitions * sizeof *self->tables,               \
+                              _Alignof(name_##_table));                        \
+        }                                                                      \
+        libv_default_free(self->offsets,                                       \
+                          (partitions + 1) * sizeof *self->offsets,            \
+                          _Alignof(size_t));                                   \
+        libv_default_free(self->tuples, self->rows * sizeof *self->tuples,     \
+                          _Alignof(name_##_tuple));                            \
+        libv_default_free(self->next, self->rows * sizeof *self->next,         \
+                          _Alignof(size_t));                                   \
+        *self = (name_){0};                                                    \
+    }                                                                          \
+    static inline uint64_t name_##_hash_key(const key_* key) {                 \
+        return name_##_table_policy.key->hash(key);                            \
+    }                                                                          \
+    VJOIN_DECLARE_SCATTER_(name_, build, build_vec_, build_type_, key_,        \
+                           build_key_)                                         \
+    VJOIN_DECLARE_SCATTER_(name_, probe, probe_vec_, probe_type_, key_,        \
+                           probe_key_)                                         \
+    static inline void name_##_build_partition(void* ctx, size_t worker,       \
+                                               size_t p) {                     \
+        name_* self = ctx;                                                     \
+        const vmap_policy* policy = &name_##_table_policy;                     \
+        size_t start = self->offsets[p], end = self->offsets[p + 1];           \
+        size_t count = end - start;                                            \
+        /* sized so the table never has to grow while building */              \
+        name_##_table* table = &self->tables[p];                               \
+        *table = name_##_table_new(count + count / 7 + 1);                     \
+        /* walk backwards so every chain lists its rows in build order */      \
+        for (size_t i = end; i-- > start;) {                                   \
+            const name_##_tuple* t = &self->tuples[i];                         \
+            vmap_prepare_insert res = vmap_raw_find_or_prepare_insert(         \
+                policy, &table->set, &t->key,                                  \
+                t->hash & (table->set.capacity - 1));                          \
+            name_##_table_entry* entry = policy->slot->get(                    \
+                table->set.slots + res.index * policy->slot->size);            \
+            if (res.inserted) {                                                \
+                entry->key = t->key;                                           \
+                self->next[i] = VJOIN_NONE;                                    \
+            } else {                                                           \
+                self->next[i] = entry->value;                                  \
+            }                                                                  \
+            entry->value = i;                                                  \
+        }                                                                      \
+    }                                                                          \
+    static inline int name_##_build(name_* self, const build_vec_* rows,       \
+                                    size_t threads) {                          \
+        name_##_free(self);                                                    \
+        self->rows = build_vec_##_size(rows);                                  \
+        self->bits = vjoin_radix_bits(                                         \
+            self->rows, sizeof(name_##_tuple) + sizeof(size_t) +               \
+                            2 * sizeof(name_##_table_slot));                   \
+        size_t partitions = name_##_num_partitions(self);                      \
+        self->offsets = libv_default_alloc(                                    \
+            (partitions + 1) * sizeof *self->offsets, _Alignof(size_t));       \
+        self->tuples =                                                         \
+            name_##_partition_build(rows, self->bits, self->offsets);          \
+        self->next = libv_default_alloc(self->rows * sizeof *self->next,       \
+                                        _Alignof(size_t));                     \
+        self->tables = libv_default_alloc(partitions * sizeof *self->tables,   \
+                                          _Alignof(name_##_table));            \
+        vjoin_raw_parallel_for(partitions, threads, name_##_build_partition,   \
+                               self);                                          \
+        return LIBV_OK;                                                        \
+    }                                                                          \
+    typedef struct {                                                           \
+        const name_* self;                                                     \
+        const name_##_tuple* tuples;                                           \
+        const size_t* offsets;                                                 \
+        vjoin_pair_vec* outs;                                                  \
+        atomic_int err;                                                        \
+    } name_##_probe_ctx;                                                       \
+    static inline void name_##_probe_partition(void* ctx_, size_t worker,      \
+                                               size_t p) {                     \
+        name_##_probe_ctx* ctx = ctx_;                                         \
+        const name_* self = ctx->self;                                         \
+        const vmap_policy* policy = &name_##_table_policy;                     \
+        const vmap_raw* table = &self->tables[p].set;                          \
+        vjoin_pair_vec* out = &ctx->outs[worker];                              \
+        if (vmap_raw_is_empty(table)) {                                        \
+            return;                                                            \
+        }                                                                      \
+        for (size_t i = ctx->offsets[p]; i < ctx->offsets[p + 1]; ++i) {       \
+            const name_##_tuple* t = &ctx->tuples[i];                          \
+            vmap_raw_iter it = vmap_raw_find_hinted(                           \
+                policy, table, &t->key, t->hash & (table->capacity - 1));      \
+            const name_##_table_entry* entry = vmap_raw_iter_get(policy, &it); \
+            if (entry == NULL) {                                               \
+                continue;                                                      \
+            }                                                                  \
+            for (size_t j = entry->value; j != VJOIN_NONE;                     \
+                 j = self->next[j]) {                                          \
+                vjoin_pair pair = {self->tuples[j].index, t->index};           \
+                if (vjoin_pair_vec_push_back(out, &pair) == LIBV_ERR) {        \
+                    atomic_store(&ctx->err, 1);                                \
+                    return;                                                    \
+                }                                                              \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+    static inline int name_##_probe(const name_* self,                         \
+                                    const probe_vec_* rows, size_t threads,    \
+                                    vjoin_pair_vec* out) {                     \
+        size_t partitions = name_##_num_partitions(self);                      \
+        if (self->tables == NULL) {                                            \
+            return LIBV_ERR;                                                   \
+        }                                                                      \
+        if (threads == 0) {                                                    \
+            threads = 1;                                                       \
+        }                                                                      \
+        name_##_probe_ctx ctx = {0};                                           \
+        ctx.self = self;                                                       \
+        size_t* offsets = libv_default_alloc(                                  \
+            (partitions + 1) * sizeof *offsets, _Alignof(size_t));             \
+        ctx.offsets = offsets;                                                 \
+        ctx.tuples = name_##_partition_probe(rows, self->bits, offsets);       \
+        ctx.outs = libv_default_alloc(threads * sizeof *ctx.outs,              \
+                                      _Alignof(vjoin_pair_vec));               \
+        for (size_t i = 0; i < threads; ++i) {                                 \
+            ctx.outs[i] = vjoin_pair_vec_new();                                \
+        }                                                                      \
+        vjoin_raw_parallel_for(partitions, threads, name_##_probe_partition,   \
+                               &ctx);                                          \
+        int res = atomic_load(&ctx.err) ? LIBV_ERR : LIBV_OK;                  \
+        for (size_t i = 0; i < threads; ++i) {                                 \
+            if (res == LIBV_OK &&                                              \
+                vjoin_pair_vec_append(out, &ctx.outs[i]) == LIBV_ERR) {        \
+                res = LIBV_ERR;                                                \
+            }                                                                  \
+            vjoin_pair_vec_free(&ctx.outs[i]);                                 \
+        }                                                                      \
+        libv_default_free(ctx.outs, threads * sizeof *ctx.outs,                \
+                          _Alignof(vjoin_pair_vec));                           \
+        libv_default_free((void*)ctx.tuples,                                   \
+                          probe_vec_##_size(rows) * sizeof *ctx.tuples,        \
+                          _Alignof(name_##_tuple));                            \
+        libv_default_free(offsets, (partitions + 1) * sizeof *offsets,         \
+                          _Alignof(size_t));                                   \
+        return res;                                                            \
+    }                                                                          \
+    static inline int name_##_join(const build_vec_* build,                    \
+                                   const probe_vec_* probe, size_t threads,    \
+                                   vjoin_pair_vec* out) {                      \
+        name_ self = name_##_new();                                            \
+        int res = name_##_build(&self, build, threads);                        \
+        if (res == LIBV_OK) {                                                  \
+            res = name_##_probe(&self, probe, threads, out);                   \
+        }                                                                      \
+        name_##_free(&self);                                                   \
+        return res;                                                            \
+    }                                                                          \
+    LIBV_END                                                                   \
+    /* Force a semicolon. */ struct name_##_needstrailingsemicolon_ { int x; }
+
+LIBV_END
+
+#endif // __LIBV_VJOIN_H__
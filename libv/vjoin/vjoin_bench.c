@@ -0,0 +1,78 @@
+#include "vjoin.h"
+#include <time.h>
+
+typedef struct {
+    uint64_t id;
+    uint64_t payload;
+} row;
+
+static inline uint64_t row_key(const row* r) { return r->id; }
+
+VEC_DECLARE_DEFAULT(row_vec, row);
+
+VJOIN_DECLARE(row_join, row_vec, row, row_vec, row, uint64_t, row_key,
+              row_key);
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static uint64_t xorshift(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static void bench(size_t rows, size_t threads) {
+    row_vec build = row_vec_new();
+    row_vec probe = row_vec_new();
+    vjoin_pair_vec out = vjoin_pair_vec_new();
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+
+    row_vec_reserve(&build, rows);
+    row_vec_reserve(&probe, rows);
+    for (size_t i = 0; i < rows; ++i) {
+        row r = {i, i};
+        row_vec_push_back(&build, &r);
+        r.id = xorshift(&state) % (rows * 2);
+        row_vec_push_back(&probe, &r);
+    }
+
+    row_join j = row_join_new();
+
+    double start = now_seconds();
+    row_join_build(&j, &build, threads);
+    double built = now_seconds();
+    row_join_probe(&j, &probe, threads, &out);
+    double probed = now_seconds();
+
+    printf("rows: %10zu threads: %2zu partitions: %5zu build: %8.3fs "
+           "(%6.1f Mrows/s) probe: %8.3fs (%6.1f Mrows/s) matches: %zu\n",
+           rows, threads, row_join_num_partitions(&j), built - start,
+           (double)rows / (built - start) / 1e6, probed - built,
+           (double)rows / (probed - built) / 1e6, vjoin_pair_vec_size(&out));
+
+    row_join_free(&j);
+    vjoin_pair_vec_free(&out);
+    row_vec_free(&probe);
+    row_vec_free(&build);
+}
+
+// usage: vjoin_bench [threads] [rows...]
+// defaults to 1M and 10M rows, pass 100000000 explicitly for the large run.
+int main(int argc, char* argv[]) {
+    size_t threads = argc > 1 ? strtoull(argv[1], NULL, 10) : 4;
+    if (argc > 2) {
+        for (int i = 2; i < argc; ++i) {
+            bench(strtoull(argv[i], NULL, 10), threads);
+        }
+        return 0;
+    }
+    bench(1000000, threads);
+    bench(10000000, threads);
+    return 0;
+}
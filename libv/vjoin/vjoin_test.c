@@ -0,0 +1,131 @@
+#include "libv/vtest/vtest.h"
+#include "vjoin.h"
+
+typedef struct {
+    uint64_t id;
+    uint64_t payload;
+} row;
+
+static inline uint64_t row_key(const row* r) { return r->id; }
+
+VEC_DECLARE_DEFAULT(row_vec, row);
+
+VJOIN_DECLARE(row_join, row_vec, row, row_vec, row, uint64_t, row_key,
+              row_key);
+
+static size_t nested_loop_count(const row_vec* build, const row_vec* probe) {
+    size_t count = 0;
+    for (size_t i = 0; i < row_vec_size(build); ++i) {
+        for (size_t j = 0; j < row_vec_size(probe); ++j) {
+            if (row_vec_get_at(build, i)->id == row_vec_get_at(probe, j)->id) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+static void assert_pairs_match(const row_vec* build, const row_vec* probe,
+                               const vjoin_pair_vec* out) {
+    for (size_t i = 0; i < vjoin_pair_vec_size(out); ++i) {
+        const vjoin_pair* pair = vjoin_pair_vec_get_at(out, i);
+        assert_uint_eq(row_vec_get_at(build, pair->build)->id,
+                       row_vec_get_at(probe, pair->probe)->id);
+    }
+}
+
+TEST(vjoin, empty) {
+    row_vec build = row_vec_new();
+    row_vec probe = row_vec_new();
+    vjoin_pair_vec out = vjoin_pair_vec_new();
+
+    assert_int_eq(row_join_join(&build, &probe, 1, &out), LIBV_OK);
+    assert_uint_eq(vjoin_pair_vec_size(&out), 0);
+
+    vjoin_pair_vec_free(&out);
+    row_vec_free(&probe);
+    row_vec_free(&build);
+}
+
+TEST(vjoin, unique_keys) {
+    row_vec build = row_vec_new();
+    row_vec probe = row_vec_new();
+    vjoin_pair_vec out = vjoin_pair_vec_new();
+
+    for (uint64_t i = 0; i < 100; ++i) {
+        row r = {i, i * 10};
+        row_vec_push_back(&build, &r);
+    }
+    for (uint64_t i = 50; i < 150; ++i) {
+        row r = {i, i};
+        row_vec_push_back(&probe, &r);
+    }
+
+    assert_int_eq(row_join_join(&build, &probe, 1, &out), LIBV_OK);
+    assert_uint_eq(vjoin_pair_vec_size(&out), 50);
+    assert_pairs_match(&build, &probe, &out);
+
+    vjoin_pair_vec_free(&out);
+    row_vec_free(&probe);
+    row_vec_free(&build);
+}
+
+TEST(vjoin, duplicate_keys) {
+    row_vec build = row_vec_new();
+    row_vec probe = row_vec_new();
+    vjoin_pair_vec out = vjoin_pair_vec_new();
+
+    for (uint64_t i = 0; i < 300; ++i) {
+        row r = {i % 7, i};
+        row_vec_push_back(&build, &r);
+    }
+    for (uint64_t i = 0; i < 200; ++i) {
+        row r = {i % 11, i};
+        row_vec_push_back(&probe, &r);
+    }
+
+    assert_int_eq(row_join_join(&build, &probe, 1, &out), LIBV_OK);
+    assert_uint_eq(vjoin_pair_vec_size(&out),
+                   nested_loop_count(&build, &probe));
+    assert_pairs_match(&build, &probe, &out);
+
+    vjoin_pair_vec_free(&out);
+    row_vec_free(&probe);
+    row_vec_free(&build);
+}
+
+TEST(vjoin, partitioned_parallel) {
+    row_vec build = row_vec_new();
+    row_vec probe = row_vec_new();
+    vjoin_pair_vec out = vjoin_pair_vec_new();
+
+    const uint64_t n = 200000;
+    for (uint64_t i = 0; i < n; ++i) {
+        row r = {i, i};
+        row_vec_push_back(&build, &r);
+    }
+    for (uint64_t i = 0; i < n; i += 2) {
+        row r = {i, i};
+        row_vec_push_back(&probe, &r);
+        row_vec_push_back(&probe, &r);
+    }
+
+    row_join j = row_join_new();
+    assert_int_eq(row_join_build(&j, &build, 4), LIBV_OK);
+    assert_true(row_join_num_partitions(&j) > 1);
+
+    assert_int_eq(row_join_probe(&j, &probe, 4, &out), LIBV_OK);
+    assert_uint_eq(vjoin_pair_vec_size(&out), n);
+    assert_pairs_match(&build, &probe, &out);
+
+    vjoin_pair_vec_clear(&out);
+    assert_int_eq(row_join_probe(&j, &probe, 1, &out), LIBV_OK);
+    assert_uint_eq(vjoin_pair_vec_size(&out), n);
+
+    row_join_free(&j);
+    vjoin_pair_vec_free(&out);
+    row_vec_free(&probe);
+    row_vec_free(&build);
+}
+
+VTEST_MAIN()
@@ -143,11 +143,16 @@ typedef struct {
     const vmap_slot_policy* slot;
     const vmap_object_policy* object;
     const vmap_key_policy* key;
+    // when set, the map uses a split layout: slots only hold the control byte
+    // and the key (object), and values live in a parallel array addressed by
+    // slot index. probing then never touches value memory.
+    const vmap_object_policy* value;
 } vmap_policy;
 
 #define VMAP_DECLARE_DEFAULT_ALLOC_POLICY(name_)                               \
     static const libv_basic_alloc_policy name_##_alloc_policy = {              \
         .alloc = libv_default_alloc,                                           \
+        .calloc = libv_default_calloc,                                         \
         .free = libv_default_free,                                             \
     }
 
@@ -164,7 +169,7 @@ typedef struct {
         value_ value;                                                          \
     } name_##_slot
 
-#define VMAP_DECLARE_SLOT_POLICY(name_, slot_)                                 \
+#define VMAP_DECLARE_SLOT_POLICY_ALIGNED(name_, slot_, align_)                 \
     static inline void name_##_slot_transfer(void* dst, void* src) {           \
         memcpy(dst, src, sizeof(slot_));                                       \
     }                                                                          \
@@ -173,23 +178,29 @@ typedef struct {
     }                                                                          \
     static const vmap_slot_policy name_##_slot_policy = {                      \
         .size = sizeof(slot_),                                                 \
-        .align = _Alignof(slot_),                                              \
+        .align = (align_) > _Alignof(slot_) ? (align_) : _Alignof(slot_),      \
         .transfer = name_##_slot_transfer,                                     \
         .get = name_##_slot_get,                                               \
     }
 
-#define VMAP_DECLARE_DEFAULT_OBJECT_POLICY(name_, type_)                       \
+#define VMAP_DECLARE_DEFAULT_OBJECT_POLICY_ALIGNED(name_, type_, align_)       \
     static inline void name_##_default_object_copy(void* dst,                  \
                                                    const void* src) {          \
         memcpy(dst, src, sizeof(type_));                                       \
     }                                                                          \
     static const vmap_object_policy name_##_object_policy = {                  \
         .size = sizeof(type_),                                                 \
-        .align = _Alignof(type_),                                              \
+        .align = (align_) > _Alignof(type_) ? (align_) : _Alignof(type_),      \
         .copy = name_##_default_object_copy,                                   \
         .dtor = NULL,                                                          \
     }
 
+#define VMAP_DECLARE_SLOT_POLICY(name_, slot_)                                 \
+    VMAP_DECLARE_SLOT_POLICY_ALIGNED(name_, slot_, _Alignof(slot_))
+
+#define VMAP_DECLARE_DEFAULT_OBJECT_POLICY(name_, type_)                       \
+    VMAP_DECLARE_DEFAULT_OBJECT_POLICY_ALIGNED(name_, type_, _Alignof(type_))
+
 #define VMAP_DECLARE_DEFAULT_KEY_POLICY(name_, key_)                           \
     static inline size_t name_##_default_key_hash(const void* key) {           \
         return rapidhash(key, sizeof(key_));                                   \
@@ -203,10 +214,10 @@ typedef struct {
         .eq = name_##_default_key_eq,                                          \
     }
 
-#define VMAP_DECLARE_DEFAULT_POLICY_(name_, key_, type_, slot_)                \
+#define VMAP_DECLARE_ALIGNED_POLICY_(name_, key_, type_, slot_, align_)        \
     LIBV_BEGIN                                                                 \
     VMAP_DECLARE_DEFAULT_ALLOC_POLICY(name_);                                  \
-    VMAP_DECLARE_SLOT_POLICY(name_, slot_);                                    \
+    VMAP_DECLARE_SLOT_POLICY_ALIGNED(name_, slot_, align_);                    \
     VMAP_DECLARE_DEFAULT_OBJECT_POLICY(name_, type_);                          \
     VMAP_DECLARE_DEFAULT_KEY_POLICY(name_, key_);                              \
     LIBV_END                                                                   \
@@ -217,6 +228,9 @@ typedef struct {
         .key = &name_##_key_policy,                                            \
     }
 
+#define VMAP_DECLARE_DEFAULT_POLICY_(name_, key_, type_, slot_)                \
+    VMAP_DECLARE_ALIGNED_POLICY_(name_, key_, type_, slot_, _Alignof(slot_))
+
 #define VMAP_DECLARE_DEFAULT_SET_POLICY(name_, key_)                           \
     VMAP_DECLARE_SET_SLOT(name_, key_);                                        \
     VMAP_DECLARE_DEFAULT_POLICY_(name_, key_, key_, name_##_slot)
@@ -225,6 +239,26 @@ typedef struct {
     VMAP_DECLARE_MAP_SLOT(name_, key_, value_);                                \
     VMAP_DECLARE_DEFAULT_POLICY_(name_, key_, type_, name_##_slot)
 
+#define VMAP_DECLARE_ALIGNED_SPLIT_MAP_POLICY(name_, key_, value_, align_)     \
+    VMAP_DECLARE_SET_SLOT(name_, key_);                                        \
+    LIBV_BEGIN                                                                 \
+    VMAP_DECLARE_DEFAULT_ALLOC_POLICY(name_);                                  \
+    VMAP_DECLARE_SLOT_POLICY_ALIGNED(name_, name_##_slot, align_);             \
+    VMAP_DECLARE_DEFAULT_OBJECT_POLICY(name_, key_);                           \
+    VMAP_DECLARE_DEFAULT_OBJECT_POLICY_ALIGNED(name_##_value, value_, align_); \
+    VMAP_DECLARE_DEFAULT_KEY_POLICY(name_, key_);                              \
+    LIBV_END                                                                   \
+    static const vmap_policy name_##_policy = {                                \
+        .alloc = &name_##_alloc_policy,                                        \
+        .slot = &name_##_slot_policy,                                          \
+        .object = &name_##_object_policy,                                      \
+        .key = &name_##_key_policy,                                            \
+        .value = &name_##_value_object_policy,                                 \
+    }
+
+#define VMAP_DECLARE_DEFAULT_SPLIT_MAP_POLICY(name_, key_, value_)             \
+    VMAP_DECLARE_ALIGNED_SPLIT_MAP_POLICY(name_, key_, value_, 1)
+
 static inline size_t vmap_normalize_capacity(size_t capacity) {
     if (capacity <= 16) {
         return 16;
@@ -238,11 +272,38 @@ static inline size_t vmap_growth_to_capacity(size_t capacity) {
 
 typedef struct {
     char* slots;
+    char* values; // only used by split layout maps
     size_t capacity;
     size_t size;
     size_t growth_left;
+    // when set, the table comes from here instead of the policy's alloc
+    const libv_allocator* allocator;
 } vmap_raw;
 
+static inline void* vmap_raw_alloc(const vmap_policy* policy,
+                                   const vmap_raw* self, size_t size,
+                                   size_t align) {
+    if (self->allocator) {
+        return self->allocator->alloc(self->allocator->ctx, size, align);
+    }
+    return policy->alloc->alloc(size, align);
+}
+
+static inline void vmap_raw_free(const vmap_policy* policy,
+                                 const vmap_raw* self, void* ptr, size_t size,
+                                 size_t align) {
+    if (self->allocator) {
+        self->allocator->free(self->allocator->ctx, ptr, size, align);
+        return;
+    }
+    policy->alloc->free(ptr, size, align);
+}
+
+static inline void* vmap_raw_value_at(const vmap_policy* policy,
+                                      const vmap_raw* self, size_t index) {
+    return self->values + index * policy->value->size;
+}
+
 static size_t vmap_raw_find_first_non_full(const vmap_policy* policy,
                                            const vmap_raw* self, size_t hash) {
     size_t index = hash;
@@ -262,10 +323,24 @@ static inline void vmap_reset_growth_left(vmap_raw* self) {
 
 static inline void vmap_initialize_slots(const vmap_policy* policy,
                                          vmap_raw* self) {
-    char* mem = policy->alloc->alloc(policy->slot->size * self->capacity,
-                                     policy->object->align);
-    memset(mem, vmap_empty, policy->slot->size * self->capacity);
+    char* mem;
+    // vmap_empty is 0, so zeroed memory is already a valid empty table. for
+    // large tables calloc (or a fresh mmap) avoids touching every page here.
+    // calloc only knows the alignment of max_align_t.
+    if (self->allocator == NULL && policy->alloc->calloc &&
+        !libv_is_over_aligned(policy->slot->align)) {
+        mem = policy->alloc->calloc(self->capacity, policy->slot->size);
+    } else {
+        mem = vmap_raw_alloc(policy, self, policy->slot->size * self->capacity,
+                             policy->slot->align);
+        memset(mem, vmap_empty, policy->slot->size * self->capacity);
+    }
     self->slots = mem;
+    if (policy->value) {
+        self->values =
+            vmap_raw_alloc(policy, self, policy->value->size * self->capacity,
+                           policy->value->align);
+    }
     *((vmap_control_byte*)(self->slots +
                            (self->capacity - 1) * policy->slot->size)) =
         vmap_sentinel;
@@ -320,6 +395,16 @@ static inline vmap_raw vmap_raw_new(const vmap_policy* policy,
     return self;
 }
 
+static inline vmap_raw vmap_raw_new_in(const vmap_policy* policy,
+                                       size_t capacity,
+                                       const libv_allocator* allocator) {
+    vmap_raw self = {0};
+    self.capacity = vmap_normalize_capacity(capacity);
+    self.allocator = allocator;
+    vmap_initialize_slots(policy, &self);
+    return self;
+}
+
 static inline size_t vmap_raw_size(const vmap_raw* self) { return self->size; }
 
 static inline size_t vmap_raw_capacity(const vmap_raw* self) {
@@ -330,23 +415,44 @@ static inline bool vmap_raw_is_empty(const vmap_raw* self) {
     return self->size == 0;
 }
 
-static inline void vmap_raw_destroy_slots(const vmap_policy* policy,
-                                          vmap_raw* self) {
+static inline void vmap_raw_destroy_elements(const vmap_policy* policy,
+                                             vmap_raw* self) {
     if (policy->object->dtor) {
         for (size_t i = 0; i < self->capacity; ++i) {
             policy->object->dtor(
                 policy->slot->get(self->slots + i * policy->slot->size));
         }
     }
+    if (policy->value && policy->value->dtor) {
+        for (size_t i = 0; i < self->capacity; ++i) {
+            const char* slot = self->slots + i * policy->slot->size;
+            if (vmap_is_full(vmap_control_byte_from_slot(slot))) {
+                policy->value->dtor(vmap_raw_value_at(policy, self, i));
+            }
+        }
+    }
+}
+
+static inline void vmap_raw_destroy_slots(const vmap_policy* policy,
+                                          vmap_raw* self) {
+    vmap_raw_destroy_elements(policy, self);
     memset(self->slots, vmap_empty, self->capacity * policy->slot->size);
     self->size = 0;
     vmap_reset_growth_left(self);
 }
 
 static inline void vmap_raw_destroy(const vmap_policy* policy, vmap_raw* self) {
-    vmap_raw_destroy_slots(policy, self);
-    policy->alloc->free(self->slots, self->capacity * policy->slot->size,
-                        policy->slot->align);
+    // the slots are about to be freed, clearing them first would only fault
+    // in every page of a large table.
+    vmap_raw_destroy_elements(policy, self);
+    vmap_raw_free(policy, self, self->slots,
+                  self->capacity * policy->slot->size, policy->slot->align);
+    if (policy->value) {
+        vmap_raw_free(policy, self, self->values,
+                      self->capacity * policy->value->size,
+                      policy->value->align);
+        self->values = NULL;
+    }
     self->size = self->capacity = self->growth_left = 0;
 }
 
@@ -354,6 +460,7 @@ static inline void vmap_raw_rehash_and_grow(const vmap_policy* policy,
                                             vmap_raw* self,
                                             size_t new_capacity) {
     char* old_slots = self->slots;
+    char* old_values = self->values;
     const size_t old_capacity = self->capacity;
 
     self->capacity = new_capacity;
@@ -370,10 +477,19 @@ static inline void vmap_raw_rehash_and_grow(const vmap_policy* policy,
         size_t target = vmap_raw_find_first_non_full(policy, self, hash);
 
         policy->slot->transfer(self->slots + target * policy->slot->size, slot);
+        if (policy->value) {
+            memcpy(vmap_raw_value_at(policy, self, target),
+                   old_values + i * policy->value->size, policy->value->size);
+        }
     }
 
-    policy->alloc->free(old_slots, old_capacity * policy->slot->size,
-                        policy->slot->align);
+    vmap_raw_free(policy, self, old_slots, old_capacity * policy->slot->size,
+                  policy->slot->align);
+    if (policy->value) {
+        vmap_raw_free(policy, self, old_values,
+                      old_capacity * policy->value->size,
+                      policy->value->align);
+    }
 }
 
 typedef struct {
@@ -402,7 +518,9 @@ vmap_raw_iter_skip_empty_or_deleted(const vmap_policy* policy,
 
 static inline vmap_raw_iter vmap_raw_iter_begin(const vmap_policy* policy,
                                                 const vmap_raw* self) {
-    return (vmap_raw_iter){self, self->slots};
+    vmap_raw_iter it = {self, self->slots};
+    vmap_raw_iter_skip_empty_or_deleted(policy, &it);
+    return it;
 }
 
 static inline vmap_raw_iter vmap_raw_iter_at(const vmap_policy* policy,
@@ -428,6 +546,16 @@ static inline void vmap_raw_iter_next(const vmap_policy* policy,
     vmap_raw_iter_skip_empty_or_deleted(policy, it);
 }
 
+// split layout only, returns the value stored alongside the iterator's key
+static inline void* vmap_raw_iter_value(const vmap_policy* policy,
+                                        const vmap_raw_iter* it) {
+    if (it->slot == NULL) {
+        return NULL;
+    }
+    size_t index = (size_t)(it->slot - it->self->slots) / policy->slot->size;
+    return vmap_raw_value_at(policy, it->self, index);
+}
+
 typedef struct {
     vmap_raw* self;
     char* slot;
@@ -518,6 +646,43 @@ vmap_raw_insert_or_assign(const vmap_policy* policy, vmap_raw* self,
                                     res.inserted};
 }
 
+// split layout insert, key is copied into the slot and value into the value
+// array. like vmap_raw_insert, an existing value is left untouched.
+static inline vmap_raw_insert_result
+vmap_raw_insert_kv(const vmap_policy* policy, vmap_raw* self, const void* key,
+                   const void* value) {
+    size_t hash = vmap_hash_key(policy, self, key);
+    vmap_prepare_insert res =
+        vmap_raw_find_or_prepare_insert(policy, self, key, hash);
+    if (res.inserted) {
+        policy->object->copy(
+            policy->slot->get(self->slots + res.index * policy->slot->size),
+            key);
+        policy->value->copy(vmap_raw_value_at(policy, self, res.index), value);
+    }
+    return (vmap_raw_insert_result){vmap_raw_iter_at(policy, self, res.index),
+                                    res.inserted};
+}
+
+static inline vmap_raw_insert_result
+vmap_raw_insert_or_assign_kv(const vmap_policy* policy, vmap_raw* self,
+                             const void* key, const void* value) {
+    size_t hash = vmap_hash_key(policy, self, key);
+    vmap_prepare_insert res =
+        vmap_raw_find_or_prepare_insert(policy, self, key, hash);
+    void* dst = vmap_raw_value_at(policy, self, res.index);
+    if (res.inserted) {
+        policy->object->copy(
+            policy->slot->get(self->slots + res.index * policy->slot->size),
+            key);
+    } else if (policy->value->dtor) {
+        policy->value->dtor(dst);
+    }
+    policy->value->copy(dst, value);
+    return (vmap_raw_insert_result){vmap_raw_iter_at(policy, self, res.index),
+                                    res.inserted};
+}
+
 static inline vmap_raw_iter vmap_raw_find_hinted(const vmap_policy* policy,
                                                  const vmap_raw* self,
                                                  const void* key, size_t hash) {
@@ -550,6 +715,9 @@ static inline void vmap_raw_erase_at(const vmap_policy* policy, vmap_raw* self,
         policy->object->dtor(
             (void*)vmap_raw_iter_get(policy, (vmap_raw_iter*)it));
     }
+    if (policy->value && policy->value->dtor) {
+        policy->value->dtor(vmap_raw_iter_value(policy, (vmap_raw_iter*)it));
+    }
     --self->size;
     *it->slot = vmap_deleted;
 }
@@ -581,6 +749,10 @@ static inline bool vmap_raw_contains(const vmap_policy* policy,
     static inline name_ name_##_new(size_t capacity) {                         \
         return (name_){vmap_raw_new(&policy_, capacity)};                      \
     }                                                                          \
+    static inline name_ name_##_new_in(size_t capacity,                        \
+                                       const libv_allocator* allocator) {      \
+        return (name_){vmap_raw_new_in(&policy_, capacity, allocator)};        \
+    }                                                                          \
     static inline void name_##_dump(name_* self) {                             \
         vmap_raw_dump(&policy_, &self->set);                                   \
     }                                                                          \
@@ -655,6 +827,113 @@ static inline bool vmap_raw_contains(const vmap_policy* policy,
 #define VMAP_DECLARE_SET(name_, policy_, key_)                                 \
     VMAP_DECLARE_(name_, policy_, key_, key_)
 
+// a map whose values are stored in a separate array from the control bytes
+// and keys. use this when values are large compared to keys.
+#define VMAP_DECLARE_SPLIT_MAP(name_, policy_, key_, value_)                   \
+    LIBV_BEGIN                                                                 \
+    typedef struct {                                                           \
+        vmap_raw set;                                                          \
+    } name_;                                                                   \
+    static inline name_ name_##_new(size_t capacity) {                         \
+        return (name_){vmap_raw_new(&policy_, capacity)};                      \
+    }                                                                          \
+    static inline name_ name_##_new_in(size_t capacity,                        \
+                                       const libv_allocator* allocator) {      \
+        return (name_){vmap_raw_new_in(&policy_, capacity, allocator)};        \
+    }                                                                          \
+    static inline void name_##_dump(name_* self) {                             \
+        vmap_raw_dump(&policy_, &self->set);                                   \
+    }                                                                          \
+    static inline void name_##_destroy(name_* self) {                          \
+        vmap_raw_destroy(&policy_, &self->set);                                \
+    }                                                                          \
+    static inline size_t name_##_size(const name_* self) {                     \
+        return vmap_raw_size(&self->set);                                      \
+    }                                                                          \
+    static inline size_t name_##_capacity(const name_* self) {                 \
+        return vmap_raw_capacity(&self->set);                                  \
+    }                                                                          \
+    static inline bool name_##_is_empty(const name_* self) {                   \
+        return vmap_raw_is_empty(&self->set);                                  \
+    }                                                                          \
+    typedef struct {                                                           \
+        vmap_raw_iter it;                                                      \
+    } name_##_iter;                                                            \
+    static inline name_##_iter name_##_iter_begin(const name_* self) {         \
+        return (name_##_iter){vmap_raw_iter_begin(&policy_, &self->set)};      \
+    }                                                                          \
+    static inline void name_##_iter_next(name_##_iter* it) {                   \
+        vmap_raw_iter_next(&policy_, &it->it);                                 \
+    }                                                                          \
+    static inline const key_* name_##_iter_get(const name_##_iter* it) {       \
+        return (const key_*)vmap_raw_iter_get(&policy_, &it->it);              \
+    }                                                                          \
+    static inline value_* name_##_iter_get_value(const name_##_iter* it) {     \
+        return (value_*)vmap_raw_iter_value(&policy_, &it->it);                \
+    }                                                                          \
+    typedef struct {                                                           \
+        name_##_iter it;                                                       \
+        bool inserted;                                                         \
+    } name_##_insert_result;                                                   \
+    static inline name_##_insert_result name_##_insert(                        \
+        name_* self, const key_* key, const value_* value) {                   \
+        vmap_raw_insert_result res =                                           \
+            vmap_raw_insert_kv(&policy_, &self->set, key, value);              \
+        return (name_##_insert_result){(name_##_iter){res.it}, res.inserted};  \
+    }                                                                          \
+    static inline name_##_insert_result name_##_insert_or_assign(              \
+        name_* self, const key_* key, const value_* value) {                   \
+        vmap_raw_insert_result res =                                           \
+            vmap_raw_insert_or_assign_kv(&policy_, &self->set, key, value);    \
+        return (name_##_insert_result){(name_##_iter){res.it}, res.inserted};  \
+    }                                                                          \
+    static inline name_##_iter name_##_find(const name_* self,                 \
+                                            const key_* key) {                 \
+        return (name_##_iter){vmap_raw_find(&policy_, &self->set, key)};       \
+    }                                                                          \
+    static inline value_* name_##_get(const name_* self, const key_* key) {    \
+        vmap_raw_iter it = vmap_raw_find(&policy_, &self->set, key);           \
+        return (value_*)vmap_raw_iter_value(&policy_, &it);                    \
+    }                                                                          \
+    static inline bool name_##_erase(name_* self, const key_* key) {           \
+        return vmap_raw_erase(&policy_, &self->set, key);                      \
+    }                                                                          \
+    static inline void name_##_clear(name_* self) {                            \
+        vmap_raw_clear(&policy_, &self->set);                                  \
+    }                                                                          \
+    static inline bool name_##_contains(name_* self, const key_* key) {        \
+        return vmap_raw_contains(&policy_, &self->set, key);                   \
+    }                                                                          \
+    LIBV_END                                                                   \
+    /* Force a semicolon. */ struct name_##_needstrailingsemicolon_ { int x; }
+
+#define VMAP_DECLARE_DEFAULT_SPLIT_MAP(name_, key_, value_)                    \
+    VMAP_DECLARE_DEFAULT_SPLIT_MAP_POLICY(name_, key_, value_);                \
+    VMAP_DECLARE_SPLIT_MAP(name_, name_##_policy, key_, value_)
+
+// the default maps with their slot (and value) arrays starting on a cache
+// line, so the storage can be scanned with aligned vector loads
+#define VMAP_DECLARE_CACHE_ALIGNED_SET(name_, key_)                            \
+    VMAP_DECLARE_SET_SLOT(name_, key_);                                        \
+    VMAP_DECLARE_ALIGNED_POLICY_(name_, key_, key_, name_##_slot,              \
+                                 LIBV_CACHE_LINE_SIZE);                        \
+    VMAP_DECLARE_(name_, name_##_policy, key_, key_)
+
+#define VMAP_DECLARE_CACHE_ALIGNED_MAP(name_, key_, value_)                    \
+    typedef struct {                                                           \
+        key_ key;                                                              \
+        value_ value;                                                          \
+    } name_##_entry;                                                           \
+    VMAP_DECLARE_MAP_SLOT(name_, key_, value_);                                \
+    VMAP_DECLARE_ALIGNED_POLICY_(name_, key_, name_##_entry, name_##_slot,     \
+                                 LIBV_CACHE_LINE_SIZE);                        \
+    VMAP_DECLARE_(name_, name_##_policy, key_, name_##_entry)
+
+#define VMAP_DECLARE_CACHE_ALIGNED_SPLIT_MAP(name_, key_, value_)              \
+    VMAP_DECLARE_ALIGNED_SPLIT_MAP_POLICY(name_, key_, value_,                 \
+                                          LIBV_CACHE_LINE_SIZE);               \
+    VMAP_DECLARE_SPLIT_MAP(name_, name_##_policy, key_, value_)
+
 LIBV_END
 
 #endif // __LIBV_VMAP_H__
@@ -1,6 +1,7 @@
 #include "libv/vec/vec.h"
 #include "libv/vtest/vtest.h"
 #include "vmap.h"
+#include <stdint.h>
 
 TEST(capacity, normalize_capacity) {
     assert_uint_eq(vmap_normalize_capacity(0), 16);
@@ -281,4 +282,86 @@ TEST(vmap, iterates) {
     int_set_destroy(&t);
 }
 
+typedef struct {
+    int id;
+    char payload[200];
+} big_value;
+
+VMAP_DECLARE_DEFAULT_SPLIT_MAP(big_map, int, big_value);
+
+TEST(vmap, split_map) {
+    big_map t = big_map_new(0);
+
+    assert_uint_eq(big_map_policy.slot->size, sizeof(big_map_slot));
+    assert_true(sizeof(big_map_slot) < sizeof(big_value));
+
+    for (int i = 0; i < 1000; ++i) {
+        big_value v = {0};
+        v.id = i;
+        memset(v.payload, i & 0xFF, sizeof v.payload);
+        big_map_insert_result res = big_map_insert(&t, &i, &v);
+        assert_true(res.inserted);
+        assert_int_eq(*big_map_iter_get(&res.it), i);
+        assert_int_eq(big_map_iter_get_value(&res.it)->id, i);
+    }
+    assert_uint_eq(big_map_size(&t), 1000);
+
+    for (int i = 0; i < 1000; ++i) {
+        big_value* v = big_map_get(&t, &i);
+        assert_ptr_nonnull(v);
+        assert_int_eq(v->id, i);
+        assert_int_eq((unsigned char)v->payload[199], i & 0xFF);
+    }
+
+    int missing = 1000;
+    assert_ptr_null(big_map_get(&t, &missing));
+
+    big_value v = {0};
+    v.id = -1;
+    int key = 5;
+    big_map_insert_result res = big_map_insert(&t, &key, &v);
+    assert_false(res.inserted);
+    assert_int_eq(big_map_get(&t, &key)->id, 5);
+
+    res = big_map_insert_or_assign(&t, &key, &v);
+    assert_false(res.inserted);
+    assert_int_eq(big_map_get(&t, &key)->id, -1);
+
+    assert_true(big_map_erase(&t, &key));
+    assert_ptr_null(big_map_get(&t, &key));
+    assert_uint_eq(big_map_size(&t), 999);
+
+    size_t count = 0;
+    for (big_map_iter it = big_map_iter_begin(&t); big_map_iter_get(&it);
+         big_map_iter_next(&it)) {
+        assert_int_eq(*big_map_iter_get(&it), big_map_iter_get_value(&it)->id);
+        count++;
+    }
+    assert_uint_eq(count, 999);
+
+    big_map_destroy(&t);
+}
+
+VMAP_DECLARE_CACHE_ALIGNED_SET(aligned_set, int);
+VMAP_DECLARE_CACHE_ALIGNED_SPLIT_MAP(aligned_map, int, big_value);
+
+TEST(vmap, cache_aligned) {
+    aligned_set s = aligned_set_new(0);
+    aligned_map m = aligned_map_new(0);
+    for (int i = 0; i < 1000; ++i) {
+        big_value v = {.id = i};
+        assert_true(aligned_set_insert(&s, &i).inserted);
+        assert_true(aligned_map_insert(&m, &i, &v).inserted);
+        assert_uint_eq((uintptr_t)s.set.slots % LIBV_CACHE_LINE_SIZE, 0);
+        assert_uint_eq((uintptr_t)m.set.slots % LIBV_CACHE_LINE_SIZE, 0);
+        assert_uint_eq((uintptr_t)m.set.values % LIBV_CACHE_LINE_SIZE, 0);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        assert_true(aligned_set_contains(&s, &i));
+        assert_int_eq(aligned_map_get(&m, &i)->id, i);
+    }
+    aligned_set_destroy(&s);
+    aligned_map_destroy(&m);
+}
+
 VTEST_MAIN()
@@ -0,0 +1,265 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2026, vincer2040
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// vmem
+// page level allocation for large buffers: anonymous mmap, transparent or
+// explicit huge pages and NUMA placement through mbind. small allocations
+// fall through to malloc. on platforms without mmap everything goes to malloc.
+
+#ifndef __LIBV_VMEM_H__
+
+#define __LIBV_VMEM_H__
+
+#include "libv/base/base.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+// MAP_ANONYMOUS and syscall are hidden in strict c mode. define _GNU_SOURCE
+// (or _DEFAULT_SOURCE) before the first system header, eg. -D_GNU_SOURCE,
+// defining it here is too late once anything else has been included.
+#ifndef MAP_ANONYMOUS
+#error "vmem.h needs _GNU_SOURCE defined before any system header"
+#endif // MAP_ANONYMOUS
+#define LIBV_VMEM_HAVE_MMAP 1
+#else
+#define LIBV_VMEM_HAVE_MMAP 0
+#endif // __linux__
+
+LIBV_BEGIN
+
+#ifndef LIBV_VMEM_HUGE_PAGE_SIZE
+#define LIBV_VMEM_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#endif // LIBV_VMEM_HUGE_PAGE_SIZE
+
+typedef enum {
+    vmem_huge_none,
+    // MADV_HUGEPAGE on a huge page aligned mapping
+    vmem_huge_transparent,
+    // MAP_HUGETLB from the reserved pool, falls back to transparent
+    vmem_huge_explicit,
+} vmem_huge_mode;
+
+// these match the kernel's MPOL_* values
+typedef enum {
+    vmem_numa_default = 0,
+    vmem_numa_preferred = 1,
+    vmem_numa_bind = 2,
+    vmem_numa_interleave = 3,
+} vmem_numa_mode;
+
+typedef struct {
+    size_t threshold; // allocations smaller than this go to malloc
+    vmem_huge_mode huge;
+    vmem_numa_mode numa;
+    unsigned long nodemask; // nodes used by vmem_numa_{preferred,bind,...}
+} vmem_options;
+
+static inline size_t vmem_page_size(void) {
+#if LIBV_VMEM_HAVE_MMAP
+    return (size_t)sysconf(_SC_PAGESIZE);
+#else
+    return 4096;
+#endif
+}
+
+static inline size_t vmem_round_up(size_t size, size_t page) {
+    return (size + page - 1) & ~(page - 1);
+}
+
+// the length actually mapped for an allocation of size bytes. vmem_free
+// recomputes it, so it must only depend on the options and the size.
+static inline size_t vmem_mapping_size(const vmem_options* options,
+                                       size_t size) {
+    if (options->huge == vmem_huge_none) {
+        return vmem_round_up(size, vmem_page_size());
+    }
+    return vmem_round_up(size, LIBV_VMEM_HUGE_PAGE_SIZE);
+}
+
+static inline bool vmem_is_mapped(const vmem_options* options, size_t size) {
+    return LIBV_VMEM_HAVE_MMAP && size >= options->threshold;
+}
+
+#if LIBV_VMEM_HAVE_MMAP
+
+// maps length bytes starting on an align boundary by over-mapping and
+// trimming the ends. returns MAP_FAILED on failure.
+static inline void* vmem_map_aligned(size_t length, size_t align) {
+    if (align <= vmem_page_size()) {
+        return mmap(NULL, length, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    char* raw = mmap(NULL, length + align, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return MAP_FAILED;
+    }
+    char* aligned =
+        (char*)(((uintptr_t)raw + align - 1) & ~(uintptr_t)(align - 1));
+    if (aligned != raw) {
+        munmap(raw, aligned - raw);
+    }
+    if (aligned + length != raw + length + align) {
+        munmap(aligned + length, (raw + length + align) - (aligned + length));
+    }
+    return aligned;
+}
+
+// placement is best effort, a kernel without NUMA support simply keeps the
+// default policy.
+static inline void vmem_numa_apply(const vmem_options* options, void* ptr,
+                                   size_t length) {
+#ifdef SYS_mbind
+    if (options->numa == vmem_numa_default) {
+        return;
+    }
+    unsigned long nodemask = options->nodemask;
+    // the kernel reads maxnode - 1 bits
+    syscall(SYS_mbind, ptr, length, (int)options->numa, &nodemask,
+            sizeof(nodemask) * 8 + 1, 0);
+#else
+    LIBV_UNUSED(options);
+    LIBV_UNUSED(ptr);
+    LIBV_UNUSED(length);
+#endif // SYS_mbind
+}
+
+#endif // LIBV_VMEM_HAVE_MMAP
+
+// fresh anonymous mappings are zero filled, so mapped allocations are always
+// zeroed. zero only matters for the malloc fallback. align must be a power of
+// two, mappings start on a page (or huge page) boundary anyway.
+static inline void* vmem_alloc(const vmem_options* options, size_t size,
+                               size_t align, bool zero) {
+    if (!vmem_is_mapped(options, size)) {
+        if (libv_is_over_aligned(align)) {
+            void* ptr = libv_default_alloc(size, align);
+            if (zero) {
+                memset(ptr, 0, size);
+            }
+            return ptr;
+        }
+        void* ptr = zero ? calloc(1, size) : malloc(size);
+        if (!ptr) {
+            libv_panic("failed to allocate %zu bytes\n", size);
+        }
+        return ptr;
+    }
+#if LIBV_VMEM_HAVE_MMAP
+    size_t length = vmem_mapping_size(options, size);
+    size_t boundary = options->huge == vmem_huge_none
+                          ? vmem_page_size()
+                          : LIBV_VMEM_HUGE_PAGE_SIZE;
+    if (align > boundary) {
+        boundary = align;
+    }
+    void* ptr = MAP_FAILED;
+    bool hugetlb = false;
+    LIBV_UNUSED(hugetlb); // only read with MAP_HUGETLB and MADV_HUGEPAGE
+#ifdef MAP_HUGETLB
+    // huge pages from the pool are only huge page aligned
+    if (options->huge == vmem_huge_explicit &&
+        align <= LIBV_VMEM_HUGE_PAGE_SIZE) {
+        ptr = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        hugetlb = ptr != MAP_FAILED;
+    }
+#endif // MAP_HUGETLB
+    if (ptr == MAP_FAILED) {
+        ptr = vmem_map_aligned(length, boundary);
+    }
+    if (ptr == MAP_FAILED) {
+        libv_panic("failed to map %zu bytes\n", length);
+    }
+#ifdef MADV_HUGEPAGE
+    if (options->huge != vmem_huge_none && !hugetlb) {
+        madvise(ptr, length, MADV_HUGEPAGE);
+    }
+#endif // MADV_HUGEPAGE
+    // must happen before the first touch, which is what places the pages
+    vmem_numa_apply(options, ptr, length);
+    return ptr;
+#else
+    return NULL;
+#endif // LIBV_VMEM_HAVE_MMAP
+}
+
+static inline void vmem_free(const vmem_options* options, void* ptr,
+                             size_t size, size_t align) {
+    if (ptr == NULL) {
+        return;
+    }
+    if (!vmem_is_mapped(options, size)) {
+        libv_default_free(ptr, size, align);
+        return;
+    }
+#if LIBV_VMEM_HAVE_MMAP
+    munmap(ptr, vmem_mapping_size(options, size));
+#endif // LIBV_VMEM_HAVE_MMAP
+}
+
+// declares name_##_alloc_policy, a libv_basic_alloc_policy backed by vmem.
+// the remaining arguments initialize the vmem_options, eg.
+//
+// VMEM_DECLARE_ALLOC_POLICY(big_set, .threshold = 1 << 21,
+//                           .huge = vmem_huge_transparent,
+//                           .numa = vmem_numa_interleave, .nodemask = 0x3);
+#define VMEM_DECLARE_ALLOC_POLICY(name_, ...)                                  \
+    LIBV_BEGIN                                                                 \
+    static const vmem_options name_##_vmem_options = {__VA_ARGS__};            \
+    static inline void* name_##_vmem_alloc(size_t size, size_t align) {        \
+        return vmem_alloc(&name_##_vmem_options, size, align, false);          \
+    }                                                                          \
+    static inline void* name_##_vmem_calloc(size_t nmem, size_t size) {        \
+        if (size != 0 && nmem > SIZE_MAX / size) {                             \
+            libv_panic("calloc of %zu * %zu bytes overflows\n", nmem, size);   \
+        }                                                                      \
+        return vmem_alloc(&name_##_vmem_options, nmem * size,                  \
+                          _Alignof(max_align_t), true);                        \
+    }                                                                          \
+    static inline void name_##_vmem_free(void* ptr, size_t size,               \
+                                         size_t align) {                       \
+        vmem_free(&name_##_vmem_options, ptr, size, align);                    \
+    }                                                                          \
+    LIBV_END                                                                   \
+    static const libv_basic_alloc_policy name_##_alloc_policy = {              \
+        .alloc = name_##_vmem_alloc,                                           \
+        .calloc = name_##_vmem_calloc,                                         \
+        .free = name_##_vmem_free,                                             \
+    }
+
+LIBV_END
+
+#endif // __LIBV_VMEM_H__
@@ -0,0 +1,170 @@
+#include "vmem.h"
+#include "libv/vmap/vmap.h"
+#include "libv/vtest/vtest.h"
+
+static bool is_zero(const void* ptr, size_t size) {
+    const unsigned char* bytes = ptr;
+    for (size_t i = 0; i < size; ++i) {
+        if (bytes[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(vmem, below_threshold) {
+    vmem_options options = {.threshold = 1 << 20};
+
+    void* ptr = vmem_alloc(&options, 100, _Alignof(max_align_t), true);
+    assert_ptr_nonnull(ptr);
+    assert_false(vmem_is_mapped(&options, 100));
+    assert_true(is_zero(ptr, 100));
+
+    vmem_free(&options, ptr, 100, _Alignof(max_align_t));
+}
+
+TEST(vmem, mapped) {
+    vmem_options options = {.threshold = 4096};
+    const size_t size = 3 * 4096 + 10;
+
+    unsigned char* ptr =
+        vmem_alloc(&options, size, _Alignof(max_align_t), false);
+    assert_ptr_nonnull(ptr);
+    assert_true(vmem_is_mapped(&options, size));
+    assert_uint_eq((uintptr_t)ptr % vmem_page_size(), 0);
+    assert_true(is_zero(ptr, size));
+    memset(ptr, 0xAB, size);
+
+    vmem_free(&options, ptr, size, _Alignof(max_align_t));
+}
+
+TEST(vmem, transparent_huge_pages) {
+    vmem_options options = {
+        .threshold = 4096,
+        .huge = vmem_huge_transparent,
+    };
+    const size_t size = LIBV_VMEM_HUGE_PAGE_SIZE + 1;
+
+    unsigned char* ptr =
+        vmem_alloc(&options, size, _Alignof(max_align_t), true);
+    assert_ptr_nonnull(ptr);
+    assert_uint_eq((uintptr_t)ptr % LIBV_VMEM_HUGE_PAGE_SIZE, 0);
+    assert_uint_eq(vmem_mapping_size(&options, size),
+                   2 * LIBV_VMEM_HUGE_PAGE_SIZE);
+    memset(ptr, 0xCD, size);
+
+    vmem_free(&options, ptr, size, _Alignof(max_align_t));
+}
+
+TEST(vmem, explicit_huge_pages_fallback) {
+    // most machines have no reserved huge pages, this must still succeed
+    vmem_options options = {
+        .threshold = 4096,
+        .huge = vmem_huge_explicit,
+        .numa = vmem_numa_interleave,
+        .nodemask = 1,
+    };
+    const size_t size = LIBV_VMEM_HUGE_PAGE_SIZE;
+
+    unsigned char* ptr =
+        vmem_alloc(&options, size, _Alignof(max_align_t), true);
+    assert_ptr_nonnull(ptr);
+    assert_true(is_zero(ptr, size));
+    memset(ptr, 0xEF, size);
+
+    vmem_free(&options, ptr, size, _Alignof(max_align_t));
+}
+
+TEST(vmem, over_aligned) {
+    vmem_options options = {.threshold = 1 << 20};
+
+    // below the threshold the request goes to the aligned malloc fallback
+    for (size_t align = 64; align <= 4096; align <<= 1) {
+        unsigned char* ptr = vmem_alloc(&options, 100, align, true);
+        assert_ptr_nonnull(ptr);
+        assert_uint_eq((uintptr_t)ptr % align, 0);
+        assert_true(is_zero(ptr, 100));
+        vmem_free(&options, ptr, 100, align);
+    }
+
+    // mapped, with an alignment past the page size
+    const size_t size = 2 << 20;
+    const size_t align = 4 * vmem_page_size();
+    unsigned char* ptr = vmem_alloc(&options, size, align, false);
+    assert_ptr_nonnull(ptr);
+    assert_uint_eq((uintptr_t)ptr % align, 0);
+    memset(ptr, 0x11, size);
+    vmem_free(&options, ptr, size, align);
+}
+
+VMAP_DECLARE_SET_SLOT(aligned_set, int);
+VMEM_DECLARE_ALLOC_POLICY(aligned_set, .threshold = 1 << 20);
+VMAP_DECLARE_SLOT_POLICY_ALIGNED(aligned_set, aligned_set_slot,
+                                 LIBV_CACHE_LINE_SIZE);
+VMAP_DECLARE_DEFAULT_OBJECT_POLICY(aligned_set, int);
+VMAP_DECLARE_DEFAULT_KEY_POLICY(aligned_set, int);
+
+static const vmap_policy aligned_set_policy = {
+    .alloc = &aligned_set_alloc_policy,
+    .slot = &aligned_set_slot_policy,
+    .object = &aligned_set_object_policy,
+    .key = &aligned_set_key_policy,
+};
+
+VMAP_DECLARE_SET(aligned_set, aligned_set_policy, int);
+
+TEST(vmem, vmap_aligned_policy) {
+    aligned_set t = aligned_set_new(0);
+
+    // the table stays below the threshold, so the slots come from the
+    // aligned malloc fallback
+    for (int i = 0; i < 1000; ++i) {
+        assert_true(aligned_set_insert(&t, &i).inserted);
+        assert_uint_eq((uintptr_t)t.set.slots % LIBV_CACHE_LINE_SIZE, 0);
+    }
+
+    for (int i = 0; i < 1000; ++i) {
+        assert_true(aligned_set_contains(&t, &i));
+    }
+
+    aligned_set_destroy(&t);
+}
+
+VMAP_DECLARE_SET_SLOT(huge_set, int);
+VMEM_DECLARE_ALLOC_POLICY(huge_set, .threshold = 64 * 1024,
+                          .huge = vmem_huge_transparent);
+VMAP_DECLARE_SLOT_POLICY(huge_set, huge_set_slot);
+VMAP_DECLARE_DEFAULT_OBJECT_POLICY(huge_set, int);
+VMAP_DECLARE_DEFAULT_KEY_POLICY(huge_set, int);
+
+static const vmap_policy huge_set_policy = {
+    .alloc = &huge_set_alloc_policy,
+    .slot = &huge_set_slot_policy,
+    .object = &huge_set_object_policy,
+    .key = &huge_set_key_policy,
+};
+
+VMAP_DECLARE_SET(huge_set, huge_set_policy, int);
+
+TEST(vmem, vmap_policy) {
+    huge_set t = huge_set_new(0);
+
+    for (int i = 0; i < 100000; ++i) {
+        assert_true(huge_set_insert(&t, &i).inserted);
+    }
+
+    for (int i = 0; i < 100000; ++i) {
+        assert_true(huge_set_contains(&t, &i));
+    }
+
+    huge_set_clear(&t);
+    assert_true(huge_set_is_empty(&t));
+
+    int x = 7;
+    assert_true(huge_set_insert(&t, &x).inserted);
+    assert_true(huge_set_contains(&t, &x));
+
+    huge_set_destroy(&t);
+}
+
+VTEST_MAIN()
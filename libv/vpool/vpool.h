@@ -0,0 +1,328 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2026, vincer2040
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+// a pool of fixed size objects. slots are carved out of an arena's blocks and
+// freed slots go on an intrusive free list, so alloc and free are both O(1)
+// and never touch malloc once the pool is warm.
+
+#ifndef __LIBV_VPOOL_H__
+
+#define __LIBV_VPOOL_H__
+
+#include "libv/arena/arena.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+LIBV_BEGIN
+
+// the number of objects a vpool_cache moves to or from its pool at a time
+#ifndef LIBV_VPOOL_CACHE_SIZE
+#define LIBV_VPOOL_CACHE_SIZE 64
+#endif // LIBV_VPOOL_CACHE_SIZE
+
+typedef struct vpool_slot vpool_slot;
+
+struct vpool_slot {
+    vpool_slot* next;
+};
+
+// vpool_alloc and vpool_free are not thread safe. threads that share a pool
+// each go through their own vpool_cache instead, which only takes the lock
+// to move a batch of objects.
+typedef struct {
+    arena arena; // slots are carved out of its blocks
+    vpool_slot* free_list;
+    size_t size;  // slot size
+    size_t align; // slot alignment
+    size_t live;  // objects handed out, including those sitting in caches
+    atomic_flag lock;
+    // bumped by clear and destroy so caches drop slots from before them
+    atomic_size_t epoch;
+} vpool;
+
+static inline vpool vpool_new(size_t size, size_t align) {
+    if (align < _Alignof(vpool_slot)) {
+        align = _Alignof(vpool_slot);
+    }
+    if (size < sizeof(vpool_slot)) {
+        size = sizeof(vpool_slot);
+    }
+    return (vpool){
+        .arena = arena_new(),
+        .free_list = NULL,
+        .size = (size + align - 1) & ~(align - 1),
+        .align = align,
+        .live = 0,
+        .lock = ATOMIC_FLAG_INIT,
+        .epoch = 0,
+    };
+}
+
+// must not be called while any thread is allocating through a vpool_cache.
+// every cache notices on its next call and drops the slots it holds.
+static inline void vpool_destroy(vpool* self) {
+    arena_destroy(&self->arena);
+    self->arena = arena_new();
+    self->free_list = NULL;
+    self->live = 0;
+    atomic_fetch_add_explicit(&self->epoch, 1, memory_order_relaxed);
+}
+
+// frees every object at once, keeping the blocks for reuse. the same rules as
+// vpool_destroy apply to caches.
+static inline void vpool_clear(vpool* self) {
+    if (self->arena.head) {
+        arena_reset(&self->arena);
+    }
+    self->free_list = NULL;
+    self->live = 0;
+    atomic_fetch_add_explicit(&self->epoch, 1, memory_order_relaxed);
+}
+
+LIBV_INLINE_ALWAYS static inline void* vpool_alloc(vpool* self) {
+    vpool_slot* slot = self->free_list;
+    if (LIBV_LIKELY(slot != NULL)) {
+        self->free_list = slot->next;
+        ++self->live;
+        return slot;
+    }
+    void* ptr = arena_alloc_aligned(&self->arena, self->size, self->align);
+    if (ptr) {
+        ++self->live;
+    }
+    return ptr;
+}
+
+static inline void vpool_free(vpool* self, void* ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    vpool_slot* slot = ptr;
+    slot->next = self->free_list;
+    self->free_list = slot;
+    --self->live;
+}
+
+// block stats come from the arena, alloc_used counts the objects handed out.
+// slots on the free list are neither used nor wasted.
+static inline arena_stats vpool_stats(const vpool* self) {
+    arena_stats stats = self->arena.stats;
+    stats.alloc_used = self->live * self->size;
+    return stats;
+}
+
+static inline void vpool_lock(vpool* self) {
+    while (atomic_flag_test_and_set_explicit(&self->lock,
+                                             memory_order_acquire)) {
+    }
+}
+
+static inline void vpool_unlock(vpool* self) {
+    atomic_flag_clear_explicit(&self->lock, memory_order_release);
+}
+
+// a per thread front for a shared pool. objects allocated before the pool
+// was cleared or destroyed must not be freed through it afterwards.
+typedef struct {
+    vpool* pool;
+    vpool_slot* free_list;
+    size_t count;
+    size_t epoch;
+} vpool_cache;
+
+static inline vpool_cache vpool_cache_new(vpool* pool) {
+    size_t epoch = atomic_load_explicit(&pool->epoch, memory_order_relaxed);
+    return (vpool_cache){pool, NULL, 0, epoch};
+}
+
+// slots cached before the pool was cleared or destroyed are memory the pool
+// carves again, so they are dropped rather than handed out or returned
+static inline void vpool_cache_sync(vpool_cache* self) {
+    size_t epoch =
+        atomic_load_explicit(&self->pool->epoch, memory_order_relaxed);
+    if (LIBV_UNLIKELY(epoch != self->epoch)) {
+        self->free_list = NULL;
+        self->count = 0;
+        self->epoch = epoch;
+    }
+}
+
+LIBV_INLINE_NEVER static void* vpool_cache_refill(vpool_cache* self) {
+    vpool* pool = self->pool;
+    vpool_lock(pool);
+    for (size_t i = 0; i < LIBV_VPOOL_CACHE_SIZE; ++i) {
+        vpool_slot* slot = vpool_alloc(pool);
+        if (slot == NULL) {
+            break;
+        }
+        slot->next = self->free_list;
+        self->free_list = slot;
+        ++self->count;
+    }
+    vpool_unlock(pool);
+
+    vpool_slot* slot = self->free_list;
+    if (slot) {
+        self->free_list = slot->next;
+        --self->count;
+    }
+    return slot;
+}
+
+// hands up to n cached objects back to the pool
+static inline void vpool_cache_flush(vpool_cache* self, size_t n) {
+    vpool* pool = self->pool;
+    vpool_lock(pool);
+    for (; n > 0 && self->free_list; --n) {
+        vpool_slot* slot = self->free_list;
+        self->free_list = slot->next;
+        --self->count;
+        vpool_free(pool, slot);
+    }
+    vpool_unlock(pool);
+}
+
+LIBV_INLINE_ALWAYS static inline void* vpool_cache_alloc(vpool_cache* self) {
+    vpool_cache_sync(self);
+    vpool_slot* slot = self->free_list;
+    if (LIBV_LIKELY(slot != NULL)) {
+        self->free_list = slot->next;
+        --self->count;
+        return slot;
+    }
+    return vpool_cache_refill(self);
+}
+
+static inline void vpool_cache_free(vpool_cache* self, void* ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    vpool_cache_sync(self);
+    vpool_slot* slot = ptr;
+    slot->next = self->free_list;
+    self->free_list = slot;
+    if (LIBV_UNLIKELY(++self->count > 2 * LIBV_VPOOL_CACHE_SIZE)) {
+        vpool_cache_flush(self, LIBV_VPOOL_CACHE_SIZE);
+    }
+}
+
+// returns every cached object to the pool, call before a thread exits
+static inline void vpool_cache_release(vpool_cache* self) {
+    vpool_cache_sync(self);
+    vpool_cache_flush(self, self->count);
+}
+
+// a libv_allocator for a pool. requests that fit in a slot come from the
+// pool, anything larger falls back to malloc.
+static inline bool vpool_fits(const vpool* self, size_t size, size_t align) {
+    return size <= self->size && align <= self->align;
+}
+
+static inline void* vpool_allocator_alloc(void* ctx, size_t size,
+                                          size_t align) {
+    if (vpool_fits(ctx, size, align)) {
+        return vpool_alloc(ctx);
+    }
+    return libv_default_alloc(size, align);
+}
+
+static inline void vpool_allocator_free(void* ctx, void* ptr, size_t size,
+                                        size_t align) {
+    if (vpool_fits(ctx, size, align)) {
+        vpool_free(ctx, ptr);
+        return;
+    }
+    libv_default_free(ptr, size, align);
+}
+
+static inline void* vpool_allocator_realloc(void* ctx, void* ptr,
+                                            size_t old_size, size_t new_size,
+                                            size_t align) {
+    if (new_size == 0) {
+        vpool_allocator_free(ctx, ptr, old_size, align);
+        return NULL;
+    }
+    bool old_fits = ptr != NULL && vpool_fits(ctx, old_size, align);
+    bool new_fits = vpool_fits(ctx, new_size, align);
+    if (old_fits && new_fits) {
+        return ptr;
+    }
+    if (ptr != NULL && !old_fits && !new_fits) {
+        return libv_default_realloc(ptr, old_size, new_size, align);
+    }
+    void* new_ptr = vpool_allocator_alloc(ctx, new_size, align);
+    if (new_ptr && ptr) {
+        memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+        vpool_allocator_free(ctx, ptr, old_size, align);
+    }
+    return new_ptr;
+}
+
+static inline libv_allocator vpool_allocator(vpool* self) {
+    return (libv_allocator){
+        .ctx = self,
+        .alloc = vpool_allocator_alloc,
+        .realloc = vpool_allocator_realloc,
+        .free = vpool_allocator_free,
+    };
+}
+
+#define VPOOL_DECLARE(name_, type_)                                            \
+    LIBV_BEGIN                                                                 \
+    typedef struct {                                                           \
+        vpool pool;                                                            \
+    } name_;                                                                   \
+    static inline name_ name_##_new(void) {                                    \
+        return (name_){vpool_new(sizeof(type_), _Alignof(type_))};             \
+    }                                                                          \
+    static inline void name_##_destroy(name_* self) {                          \
+        vpool_destroy(&self->pool);                                            \
+    }                                                                          \
+    static inline void name_##_clear(name_* self) {                            \
+        vpool_clear(&self->pool);                                              \
+    }                                                                          \
+    static inline type_* name_##_alloc(name_* self) {                          \
+        return (type_*)vpool_alloc(&self->pool);                               \
+    }                                                                          \
+    static inline void name_##_free(name_* self, type_* ptr) {                 \
+        vpool_free(&self->pool, ptr);                                          \
+    }                                                                          \
+    static inline arena_stats name_##_stats(const name_* self) {               \
+        return vpool_stats(&self->pool);                                       \
+    }                                                                          \
+    LIBV_END                                                                   \
+    /* Force a semicolon. */ struct name_##_needstrailingsemicolon_ { int x; }
+
+LIBV_END
+
+#endif // __LIBV_VPOOL_H__
@@ -0,0 +1,178 @@
+#define LIBV_ARENA_IMPLEMENTATION
+#include "libv/vec/vec.h"
+#include "libv/vtest/vtest.h"
+#include "vpool.h"
+#include <pthread.h>
+#include <stdint.h>
+
+typedef struct {
+    int key;
+    double value;
+    char name[20];
+} entry;
+
+VPOOL_DECLARE(entry_pool, entry);
+
+TEST(vpool, alloc_free) {
+    entry_pool p = entry_pool_new();
+
+    entry* entries[100];
+    for (int i = 0; i < 100; ++i) {
+        entries[i] = entry_pool_alloc(&p);
+        assert_ptr_nonnull(entries[i]);
+        assert_uint_eq((uintptr_t)entries[i] % _Alignof(entry), 0);
+        entries[i]->key = i;
+    }
+    for (int i = 0; i < 100; ++i) {
+        assert_int_eq(entries[i]->key, i);
+    }
+
+    // freed slots are handed out again, most recent first
+    entry_pool_free(&p, entries[10]);
+    entry_pool_free(&p, entries[20]);
+    assert_true(entry_pool_alloc(&p) == entries[20]);
+    assert_true(entry_pool_alloc(&p) == entries[10]);
+
+    entry_pool_destroy(&p);
+}
+
+TEST(vpool, stats) {
+    vpool p = vpool_new(3, 1);
+    assert_uint_eq(p.size, sizeof(void*));
+
+    void* a = vpool_alloc(&p);
+    void* b = vpool_alloc(&p);
+    arena_stats stats = vpool_stats(&p);
+    assert_uint_eq(stats.num_blocks, 1);
+    assert_uint_eq(stats.alloc_used, 2 * sizeof(void*));
+    assert_uint_eq(stats.alloc_wasted, 0);
+
+    vpool_free(&p, a);
+    vpool_free(&p, b);
+    assert_uint_eq(vpool_stats(&p).alloc_used, 0);
+
+    vpool_alloc(&p);
+    vpool_clear(&p);
+    assert_uint_eq(vpool_stats(&p).alloc_used, 0);
+    assert_ptr_null(p.free_list);
+
+    vpool_destroy(&p);
+}
+
+#define NUM_THREADS 4
+#define NUM_ROUNDS 100
+#define NUM_OBJECTS 1000
+
+static void* cache_worker(void* arg) {
+    vpool* p = arg;
+    vpool_cache cache = vpool_cache_new(p);
+    uint64_t* objects[NUM_OBJECTS];
+    for (int round = 0; round < NUM_ROUNDS; ++round) {
+        for (int i = 0; i < NUM_OBJECTS; ++i) {
+            objects[i] = vpool_cache_alloc(&cache);
+            *objects[i] = (uintptr_t)objects[i];
+        }
+        for (int i = 0; i < NUM_OBJECTS; ++i) {
+            if (*objects[i] != (uintptr_t)objects[i]) {
+                return (void*)1;
+            }
+            vpool_cache_free(&cache, objects[i]);
+        }
+    }
+    vpool_cache_release(&cache);
+    return NULL;
+}
+
+TEST(vpool, caches) {
+    vpool p = vpool_new(sizeof(uint64_t), _Alignof(uint64_t));
+
+    pthread_t threads[NUM_THREADS];
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        pthread_create(&threads[i], NULL, cache_worker, &p);
+    }
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        void* res;
+        pthread_join(threads[i], &res);
+        assert_ptr_null(res);
+    }
+
+    assert_uint_eq(p.live, 0);
+    // objects were recycled, not carved out once per alloc
+    assert_true(vpool_stats(&p).alloc_size <
+                NUM_THREADS * NUM_ROUNDS * NUM_OBJECTS * sizeof(uint64_t));
+
+    vpool_destroy(&p);
+}
+
+TEST(vpool, cache_after_clear) {
+    vpool p = vpool_new(sizeof(uint64_t), _Alignof(uint64_t));
+    vpool_cache cache = vpool_cache_new(&p);
+
+    // the cache holds the rest of its first batch when the pool is cleared
+    assert_ptr_nonnull(vpool_cache_alloc(&cache));
+    assert_true(cache.count > 0);
+    vpool_clear(&p);
+
+    // the stale slots are dropped, so nothing is handed out twice while the
+    // pool carves its blocks again
+    void* ptrs[200];
+    for (size_t i = 0; i < 100; ++i) {
+        ptrs[i] = vpool_cache_alloc(&cache);
+        ptrs[100 + i] = vpool_alloc(&p);
+    }
+    for (size_t i = 0; i < 200; ++i) {
+        assert_ptr_nonnull(ptrs[i]);
+        for (size_t j = 0; j < i; ++j) {
+            assert_true(ptrs[i] != ptrs[j]);
+        }
+    }
+    for (size_t i = 0; i < 100; ++i) {
+        vpool_cache_free(&cache, ptrs[i]);
+        vpool_free(&p, ptrs[100 + i]);
+    }
+    vpool_cache_release(&cache);
+    assert_uint_eq(p.live, 0);
+
+    // the same after a destroy, the pool is empty and starts over
+    assert_ptr_nonnull(vpool_cache_alloc(&cache));
+    vpool_destroy(&p);
+    void* fresh = vpool_cache_alloc(&cache);
+    assert_ptr_nonnull(fresh);
+    vpool_cache_free(&cache, fresh);
+    vpool_cache_release(&cache);
+    assert_uint_eq(p.live, 0);
+
+    vpool_destroy(&p);
+}
+
+VEC_DECLARE_DEFAULT(small_vec, int);
+
+TEST(vpool, allocator) {
+    vpool p = vpool_new(16 * sizeof(int), _Alignof(int));
+    libv_allocator allocator = vpool_allocator(&p);
+
+    small_vec v = small_vec_new_in(&allocator);
+    for (int i = 0; i < 16; ++i) {
+        assert_int_eq(small_vec_push_back(&v, &i), LIBV_OK);
+    }
+    assert_uint_eq(p.live, 1);
+
+    // outgrowing the slot moves the vec to malloc
+    for (int i = 16; i < 100; ++i) {
+        assert_int_eq(small_vec_push_back(&v, &i), LIBV_OK);
+    }
+    assert_uint_eq(p.live, 0);
+    assert_int_eq(*small_vec_get_at(&v, 99), 99);
+
+    small_vec_free(&v);
+
+    small_vec w = small_vec_new_in(&allocator);
+    assert_int_eq(small_vec_push_back(&w, &(int){1}), LIBV_OK);
+    assert_uint_eq(p.live, 1);
+    small_vec_free(&w);
+    assert_uint_eq(p.live, 0);
+
+    vpool_destroy(&p);
+}
+
+VTEST_MAIN()
@@ -0,0 +1,424 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2026, vincer2040
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// vseg
+// a segmented vec. elements live in fixed size chunks found through a
+// directory of chunk pointers, so growing only allocates one more chunk and
+// never moves or copies the elements already there. pointers to elements
+// stay valid until they are removed. elements use the same vec_policy as
+// vec.
+
+#ifndef __LIBV_VSEG_H__
+
+#define __LIBV_VSEG_H__
+
+#include "libv/vec/vec.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+LIBV_BEGIN
+
+// the target size of a chunk in bytes. a chunk holds the largest power of two
+// number of elements that fits, and at least one.
+#ifndef LIBV_VSEG_CHUNK_BYTES
+#define LIBV_VSEG_CHUNK_BYTES (64 * 1024)
+#endif // LIBV_VSEG_CHUNK_BYTES
+
+typedef struct {
+    char** chunks;
+    size_t size;
+    size_t chunk_count;        // allocated chunks
+    size_t directory_capacity; // slots in chunks
+    // when set, storage comes from here instead of the policy's alloc
+    const libv_allocator* allocator;
+} vseg_raw;
+
+typedef struct {
+    const void* data;
+    size_t size;
+} vseg_raw_chunk;
+
+// log2 of the number of elements in a chunk. a constant for a given policy,
+// so it folds away once inlined.
+static inline size_t vseg_raw_shift(const vec_policy* policy) {
+    size_t elements = LIBV_VSEG_CHUNK_BYTES / policy->obj->size;
+    size_t shift = 0;
+    while ((elements >> shift) > 1) {
+        shift++;
+    }
+    return shift;
+}
+
+static inline size_t vseg_raw_chunk_size(const vec_policy* policy) {
+    return (size_t)1 << vseg_raw_shift(policy);
+}
+
+static inline char* vseg_raw_slot(const vec_policy* policy,
+                                  const vseg_raw* self, size_t index) {
+    size_t shift = vseg_raw_shift(policy);
+    size_t mask = ((size_t)1 << shift) - 1;
+    return self->chunks[index >> shift] + ((index & mask) * policy->obj->size);
+}
+
+// init / destroy
+
+static inline vseg_raw vseg_raw_new(void) {
+    vseg_raw self = {0};
+    return self;
+}
+
+static inline vseg_raw vseg_raw_new_in(const libv_allocator* allocator) {
+    vseg_raw self = {0};
+    self.allocator = allocator;
+    return self;
+}
+
+static inline void vseg_raw_clear(const vec_policy* policy, vseg_raw* self) {
+    if (policy->obj->dtor) {
+        for (size_t i = 0; i < self->size; ++i) {
+            policy->obj->dtor(vseg_raw_slot(policy, self, i));
+        }
+    }
+    self->size = 0;
+}
+
+static inline void vseg_raw_free_chunk(const vec_policy* policy,
+                                       const vseg_raw* self, char* chunk) {
+    size_t size = vseg_raw_chunk_size(policy) * policy->obj->size;
+    if (self->allocator) {
+        self->allocator->free(self->allocator->ctx, chunk, size,
+                              policy->obj->align);
+    } else {
+        policy->alloc->free(chunk, size, policy->obj->align);
+    }
+}
+
+static inline void vseg_raw_free_directory(const vec_policy* policy,
+                                           vseg_raw* self) {
+    size_t size = self->directory_capacity * sizeof(char*);
+    if (self->allocator) {
+        self->allocator->free(self->allocator->ctx, self->chunks, size,
+                              _Alignof(char*));
+    } else {
+        policy->alloc->free(self->chunks, size, _Alignof(char*));
+    }
+    self->chunks = NULL;
+    self->directory_capacity = 0;
+}
+
+static inline void vseg_raw_free(const vec_policy* policy, vseg_raw* self) {
+    vseg_raw_clear(policy, self);
+    for (size_t i = 0; i < self->chunk_count; ++i) {
+        vseg_raw_free_chunk(policy, self, self->chunks[i]);
+    }
+    self->chunk_count = 0;
+    vseg_raw_free_directory(policy, self);
+}
+
+// capacity
+
+static inline bool vseg_raw_empty(const vseg_raw* self) {
+    return self->size == 0;
+}
+
+static inline size_t vseg_raw_size(const vseg_raw* self) { return self->size; }
+
+static inline size_t vseg_raw_capacity(const vec_policy* policy,
+                                       const vseg_raw* self) {
+    return self->chunk_count << vseg_raw_shift(policy);
+}
+
+// adds one chunk. only the directory of chunk pointers is ever reallocated,
+// the elements themselves stay where they are.
+LIBV_INLINE_NEVER static int vseg_raw_add_chunk(const vec_policy* policy,
+                                                vseg_raw* self) {
+    if (self->chunk_count == self->directory_capacity) {
+        size_t old_capacity = self->directory_capacity;
+        size_t new_capacity = old_capacity == 0 ? 8 : old_capacity << 1;
+        char** tmp;
+        if (self->allocator) {
+            tmp = self->allocator->realloc(
+                self->allocator->ctx, self->chunks,
+                old_capacity * sizeof(char*), new_capacity * sizeof(char*),
+                _Alignof(char*));
+        } else {
+            tmp = policy->alloc->realloc(self->chunks,
+                                         old_capacity * sizeof(char*),
+                                         new_capacity * sizeof(char*),
+                                         _Alignof(char*));
+        }
+        if (!tmp) {
+            return LIBV_ERR;
+        }
+        self->chunks = tmp;
+        self->directory_capacity = new_capacity;
+    }
+    size_t size = vseg_raw_chunk_size(policy) * policy->obj->size;
+    char* chunk;
+    if (self->allocator) {
+        chunk = self->allocator->alloc(self->allocator->ctx, size,
+                                       policy->obj->align);
+    } else {
+        chunk = policy->alloc->alloc(size, policy->obj->align);
+    }
+    if (!chunk) {
+        return LIBV_ERR;
+    }
+    self->chunks[self->chunk_count++] = chunk;
+    return LIBV_OK;
+}
+
+static inline int vseg_raw_reserve(const vec_policy* policy, vseg_raw* self,
+                                   size_t capacity) {
+    while (vseg_raw_capacity(policy, self) < capacity) {
+        if (vseg_raw_add_chunk(policy, self) == LIBV_ERR) {
+            return LIBV_ERR;
+        }
+    }
+    return LIBV_OK;
+}
+
+// frees the chunks past the one holding the last element
+static inline void vseg_raw_shrink_to_size(const vec_policy* policy,
+                                           vseg_raw* self) {
+    size_t shift = vseg_raw_shift(policy);
+    size_t used = (self->size + ((size_t)1 << shift) - 1) >> shift;
+    while (self->chunk_count > used) {
+        vseg_raw_free_chunk(policy, self, self->chunks[--self->chunk_count]);
+    }
+    if (self->chunk_count == 0) {
+        vseg_raw_free_directory(policy, self);
+    }
+}
+
+// access
+
+static inline const void* vseg_raw_get_at_unchecked(const vec_policy* policy,
+                                                    const vseg_raw* self,
+                                                    size_t index) {
+    return vseg_raw_slot(policy, self, index);
+}
+
+static inline const void* vseg_raw_get_at(const vec_policy* policy,
+                                          const vseg_raw* self, size_t index) {
+    if (index >= self->size) {
+        return NULL;
+    }
+    return vseg_raw_slot(policy, self, index);
+}
+
+static inline void* vseg_raw_get_at_mut(const vec_policy* policy,
+                                        vseg_raw* self, size_t index) {
+    if (index >= self->size) {
+        return NULL;
+    }
+    return vseg_raw_slot(policy, self, index);
+}
+
+static inline const void* vseg_raw_back(const vec_policy* policy,
+                                        const vseg_raw* self) {
+    if (self->size == 0) {
+        return NULL;
+    }
+    return vseg_raw_slot(policy, self, self->size - 1);
+}
+
+// the number of chunks holding elements
+static inline size_t vseg_raw_chunk_count(const vec_policy* policy,
+                                          const vseg_raw* self) {
+    size_t shift = vseg_raw_shift(policy);
+    return (self->size + ((size_t)1 << shift) - 1) >> shift;
+}
+
+// the elements of chunk index as one contiguous run. every chunk but the
+// last holding elements is full.
+static inline vseg_raw_chunk vseg_raw_get_chunk(const vec_policy* policy,
+                                                const vseg_raw* self,
+                                                size_t index) {
+    vseg_raw_chunk chunk = {0};
+    size_t shift = vseg_raw_shift(policy);
+    size_t first = index << shift;
+    if (first >= self->size) {
+        return chunk;
+    }
+    size_t size = self->size - first;
+    chunk.data = self->chunks[index];
+    chunk.size = size < ((size_t)1 << shift) ? size : ((size_t)1 << shift);
+    return chunk;
+}
+
+// modification
+
+// appends an uninitialized element and returns it, NULL if growing failed.
+// it already counts towards size, so it has to be constructed before the
+// vseg is used again.
+static inline void* vseg_raw_emplace_back(const vec_policy* policy,
+                                          vseg_raw* self) {
+    if (LIBV_UNLIKELY(self->size == vseg_raw_capacity(policy, self)) &&
+        vseg_raw_add_chunk(policy, self) == LIBV_ERR) {
+        return NULL;
+    }
+    return vseg_raw_slot(policy, self, self->size++);
+}
+
+static inline int vseg_raw_push_back(const vec_policy* policy, vseg_raw* self,
+                                     const void* value) {
+    void* slot = vseg_raw_emplace_back(policy, self);
+    if (!slot) {
+        return LIBV_ERR;
+    }
+    policy->obj->copy(slot, value);
+    return LIBV_OK;
+}
+
+static inline int vseg_raw_pop_back(const vec_policy* policy, vseg_raw* self,
+                                    void* out) {
+    if (self->size == 0) {
+        return LIBV_ERR;
+    }
+    self->size--;
+    char* slot = vseg_raw_slot(policy, self, self->size);
+    if (out) {
+        policy->obj->copy(out, slot);
+    } else if (policy->obj->dtor) {
+        policy->obj->dtor(slot);
+    }
+    return LIBV_OK;
+}
+
+// iter
+
+typedef struct {
+    const vseg_raw* seg;
+    size_t position;
+} vseg_raw_iter;
+
+static inline vseg_raw_iter vseg_raw_iter_new(const vseg_raw* self) {
+    return (vseg_raw_iter){self, 0};
+}
+
+static inline const void* vseg_raw_iter_get(const vec_policy* policy,
+                                            const vseg_raw_iter* self) {
+    return vseg_raw_get_at(policy, self->seg, self->position);
+}
+
+static inline void vseg_raw_iter_next(vseg_raw_iter* self) {
+    self->position++;
+}
+
+#define VSEG_DECLARE(name_, policy_, type_)                                    \
+    LIBV_BEGIN                                                                 \
+    typedef struct {                                                           \
+        vseg_raw seg;                                                          \
+    } name_;                                                                   \
+    typedef struct {                                                           \
+        const type_* data;                                                     \
+        size_t size;                                                           \
+    } name_##_chunk;                                                           \
+    static inline name_ name_##_new(void) { return (name_){vseg_raw_new()}; }  \
+    static inline name_ name_##_new_in(const libv_allocator* allocator) {      \
+        return (name_){vseg_raw_new_in(allocator)};                            \
+    }                                                                          \
+    static inline void name_##_free(name_* self) {                             \
+        vseg_raw_free(&policy_, &self->seg);                                   \
+    }                                                                          \
+    static inline bool name_##_empty(const name_* self) {                      \
+        return vseg_raw_empty(&self->seg);                                     \
+    }                                                                          \
+    static inline size_t name_##_size(const name_* self) {                     \
+        return vseg_raw_size(&self->seg);                                      \
+    }                                                                          \
+    static inline size_t name_##_capacity(const name_* self) {                 \
+        return vseg_raw_capacity(&policy_, &self->seg);                        \
+    }                                                                          \
+    static inline int name_##_reserve(name_* self, size_t new_capacity) {      \
+        return vseg_raw_reserve(&policy_, &self->seg, new_capacity);           \
+    }                                                                          \
+    static inline void name_##_shrink_to_size(name_* self) {                   \
+        vseg_raw_shrink_to_size(&policy_, &self->seg);                         \
+    }                                                                          \
+    static inline void name_##_clear(name_* self) {                            \
+        vseg_raw_clear(&policy_, &self->seg);                                  \
+    }                                                                          \
+    static inline const type_* name_##_get_at_unchecked(const name_* self,     \
+                                                        size_t index) {        \
+        return (const type_*)vseg_raw_get_at_unchecked(&policy_, &self->seg,   \
+                                                       index);                 \
+    }                                                                          \
+    static inline const type_* name_##_get_at(const name_* self,               \
+                                              size_t index) {                  \
+        return (const type_*)vseg_raw_get_at(&policy_, &self->seg, index);     \
+    }                                                                          \
+    static inline type_* name_##_get_at_mut(name_* self, size_t index) {       \
+        return (type_*)vseg_raw_get_at_mut(&policy_, &self->seg, index);       \
+    }                                                                          \
+    static inline const type_* name_##_back(const name_* self) {               \
+        return (const type_*)vseg_raw_back(&policy_, &self->seg);              \
+    }                                                                          \
+    static inline size_t name_##_chunk_count(const name_* self) {              \
+        return vseg_raw_chunk_count(&policy_, &self->seg);                     \
+    }                                                                          \
+    static inline name_##_chunk name_##_get_chunk(const name_* self,           \
+                                                  size_t index) {              \
+        vseg_raw_chunk c = vseg_raw_get_chunk(&policy_, &self->seg, index);    \
+        return (name_##_chunk){c.data, c.size};                                \
+    }                                                                          \
+    static inline type_* name_##_emplace_back(name_* self) {                   \
+        return (type_*)vseg_raw_emplace_back(&policy_, &self->seg);            \
+    }                                                                          \
+    static inline int name_##_push_back(name_* self, const type_* value) {     \
+        return vseg_raw_push_back(&policy_, &self->seg, value);                \
+    }                                                                          \
+    static inline int name_##_pop_back(name_* self, type_* out) {              \
+        return vseg_raw_pop_back(&policy_, &self->seg, out);                   \
+    }                                                                          \
+    typedef struct {                                                           \
+        vseg_raw_iter it;                                                      \
+    } name_##_iter;                                                            \
+    static inline name_##_iter name_##_iter_new(const name_* self) {           \
+        return (name_##_iter){vseg_raw_iter_new(&self->seg)};                  \
+    }                                                                          \
+    static inline const type_* name_##_iter_get(const name_##_iter* self) {    \
+        return (const type_*)vseg_raw_iter_get(&policy_, &self->it);           \
+    }                                                                          \
+    static inline void name_##_iter_next(name_##_iter* self) {                 \
+        vseg_raw_iter_next(&self->it);                                         \
+    }                                                                          \
+    LIBV_END                                                                   \
+    /* Force a semicolon. */ struct name_##_needstrailingsemicolon_ { int x; }
+
+#define VSEG_DECLARE_DEFAULT(name_, type_)                                     \
+    VEC_DECLARE_DEFAULT_POLICY_(name_##_policy, type_)                         \
+    VSEG_DECLARE(name_, name_##_policy, type_)
+
+LIBV_END
+
+#endif // __LIBV_VSEG_H__
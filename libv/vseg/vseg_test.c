@@ -0,0 +1,162 @@
+#include "libv/vtest/vtest.h"
+#include "vseg.h"
+#include <stdint.h>
+
+VSEG_DECLARE_DEFAULT(int_seg, int);
+
+TEST(vseg, push_pop) {
+    int_seg s = int_seg_new();
+    int out;
+
+    assert_true(int_seg_empty(&s));
+    assert_int_eq(int_seg_pop_back(&s, &out), LIBV_ERR);
+    assert_ptr_null(int_seg_back(&s));
+    assert_ptr_null(int_seg_get_at(&s, 0));
+
+    for (int i = 0; i < 100000; ++i) {
+        assert_int_eq(int_seg_push_back(&s, &i), LIBV_OK);
+    }
+    assert_uint_eq(int_seg_size(&s), 100000);
+    for (int i = 0; i < 100000; ++i) {
+        assert_int_eq(*int_seg_get_at(&s, i), i);
+    }
+    assert_ptr_null(int_seg_get_at(&s, 100000));
+    assert_int_eq(*int_seg_back(&s), 99999);
+
+    *int_seg_get_at_mut(&s, 5) = -5;
+    assert_int_eq(*int_seg_get_at_unchecked(&s, 5), -5);
+
+    for (int i = 99999; i >= 50000; --i) {
+        assert_int_eq(int_seg_pop_back(&s, &out), LIBV_OK);
+        assert_int_eq(out, i);
+    }
+    assert_uint_eq(int_seg_size(&s), 50000);
+
+    int_seg_free(&s);
+    assert_true(s.seg.chunks == NULL);
+    assert_uint_eq(int_seg_capacity(&s), 0);
+}
+
+TEST(vseg, stable) {
+    int_seg s = int_seg_new();
+    int zero = 0;
+    int_seg_push_back(&s, &zero);
+    const int* first = int_seg_get_at(&s, 0);
+    size_t chunk_size = int_seg_capacity(&s);
+    assert_uint_eq(chunk_size, LIBV_VSEG_CHUNK_BYTES / sizeof(int));
+
+    const int* pointers[64];
+    for (int i = 1; i < 64 * (int)chunk_size; ++i) {
+        int* slot = int_seg_emplace_back(&s);
+        *slot = i;
+        if (i % chunk_size == 0) {
+            pointers[i / chunk_size] = slot;
+        }
+    }
+    // adding chunks never moves what is already there
+    assert_true(int_seg_get_at(&s, 0) == first);
+    for (size_t i = 1; i < 64; ++i) {
+        assert_true(int_seg_get_at(&s, i * chunk_size) == pointers[i]);
+        assert_int_eq(*pointers[i], (int)(i * chunk_size));
+    }
+    int_seg_free(&s);
+}
+
+TEST(vseg, chunks) {
+    int_seg s = int_seg_new();
+    size_t n = LIBV_VSEG_CHUNK_BYTES / sizeof(int) * 3 + 10;
+    for (size_t i = 0; i < n; ++i) {
+        int x = (int)i;
+        int_seg_push_back(&s, &x);
+    }
+    assert_uint_eq(int_seg_chunk_count(&s), 4);
+
+    size_t seen = 0;
+    for (size_t c = 0; c < int_seg_chunk_count(&s); ++c) {
+        int_seg_chunk chunk = int_seg_get_chunk(&s, c);
+        for (size_t i = 0; i < chunk.size; ++i) {
+            assert_int_eq(chunk.data[i], (int)seen++);
+        }
+    }
+    assert_uint_eq(seen, n);
+    assert_uint_eq(int_seg_get_chunk(&s, 3).size, 10);
+    assert_ptr_null(int_seg_get_chunk(&s, 4).data);
+
+    size_t i = 0;
+    for (int_seg_iter it = int_seg_iter_new(&s); int_seg_iter_get(&it);
+         int_seg_iter_next(&it)) {
+        assert_int_eq(*int_seg_iter_get(&it), (int)i++);
+    }
+    assert_uint_eq(i, n);
+
+    assert_int_eq(int_seg_reserve(&s, n * 2), LIBV_OK);
+    assert_true(int_seg_capacity(&s) >= n * 2);
+    int_seg_shrink_to_size(&s);
+    assert_uint_eq(int_seg_capacity(&s),
+                   4 * (LIBV_VSEG_CHUNK_BYTES / sizeof(int)));
+    int_seg_clear(&s);
+    int_seg_shrink_to_size(&s);
+    assert_uint_eq(int_seg_capacity(&s), 0);
+    int_seg_free(&s);
+}
+
+typedef struct {
+    char bytes[LIBV_VSEG_CHUNK_BYTES + 1];
+} huge;
+
+VSEG_DECLARE_DEFAULT(huge_seg, huge);
+
+static size_t dropped = 0;
+
+static void drop_copy(void* dst, const void* src) {
+    memcpy(dst, src, sizeof(uint64_t));
+}
+
+static bool drop_eq(const void* a, const void* b) {
+    return *(const uint64_t*)a == *(const uint64_t*)b;
+}
+
+static void drop_dtor(void* value) {
+    (void)value;
+    dropped++;
+}
+
+static const vec_object_policy drop_object_policy = {
+    sizeof(uint64_t), _Alignof(uint64_t), drop_copy, drop_eq, drop_dtor,
+};
+
+static const libv_alloc_policy drop_alloc_policy = {
+    libv_default_alloc,
+    NULL,
+    libv_default_realloc,
+    libv_default_free,
+};
+
+static const vec_policy drop_policy = {
+    &drop_alloc_policy,
+    &drop_object_policy,
+};
+
+VSEG_DECLARE(drop_seg, drop_policy, uint64_t);
+
+TEST(vseg, policy) {
+    huge_seg h = huge_seg_new();
+    huge* x = huge_seg_emplace_back(&h);
+    x->bytes[0] = 'a';
+    huge_seg_emplace_back(&h)->bytes[0] = 'b';
+    assert_uint_eq(huge_seg_capacity(&h), 2);
+    assert_int_eq(huge_seg_get_at(&h, 0)->bytes[0], 'a');
+    assert_int_eq(huge_seg_back(&h)->bytes[0], 'b');
+    huge_seg_free(&h);
+
+    drop_seg d = drop_seg_new();
+    for (uint64_t i = 0; i < 10000; ++i) {
+        drop_seg_push_back(&d, &i);
+    }
+    assert_int_eq(drop_seg_pop_back(&d, NULL), LIBV_OK);
+    assert_uint_eq(dropped, 1);
+    drop_seg_free(&d);
+    assert_uint_eq(dropped, 10000);
+}
+
+VTEST_MAIN()
@@ -0,0 +1,265 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2026, vincer2040
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// vsoa
+// a struct of arrays. every field of the element type gets its own column
+// buffer and all of them share one size and capacity, so a loop over a
+// single field only ever loads that field. columns start on a cache line
+// and hold plain data, elements are copied by assignment.
+
+#ifndef __LIBV_VSOA_H__
+
+#define __LIBV_VSOA_H__
+
+#include "libv/base/base.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+LIBV_BEGIN
+
+typedef struct {
+    size_t size;
+    size_t capacity;
+    // when set, columns come from here instead of the default allocator
+    const libv_allocator* allocator;
+} vsoa_raw;
+
+static inline vsoa_raw vsoa_raw_new(void) {
+    vsoa_raw self = {0};
+    return self;
+}
+
+static inline vsoa_raw vsoa_raw_new_in(const libv_allocator* allocator) {
+    vsoa_raw self = {0};
+    self.allocator = allocator;
+    return self;
+}
+
+static inline bool vsoa_raw_empty(const vsoa_raw* self) {
+    return self->size == 0;
+}
+
+static inline size_t vsoa_raw_size(const vsoa_raw* self) { return self->size; }
+
+static inline size_t vsoa_raw_capacity(const vsoa_raw* self) {
+    return self->capacity;
+}
+
+// the capacity to grow to once the columns are full, same steps as vec
+static inline size_t vsoa_raw_next_capacity(const vsoa_raw* self) {
+    if (self->capacity == 0) {
+        return 4;
+    }
+    if (self->capacity >= 1024) {
+        return self->capacity + (self->capacity / 2);
+    }
+    return self->capacity << 1;
+}
+
+static inline void vsoa_raw_free_column(const vsoa_raw* self, void* column,
+                                        size_t size, size_t align) {
+    if (self->allocator) {
+        self->allocator->free(self->allocator->ctx, column,
+                              self->capacity * size, align);
+    } else {
+        libv_default_free(column, self->capacity * size, align);
+    }
+}
+
+// allocates a column of capacity elements for every entry of sizes and
+// aligns. either all of them are allocated or none are.
+static inline int vsoa_raw_alloc_columns(const vsoa_raw* self, void** columns,
+                                         const size_t* sizes,
+                                         const size_t* aligns, size_t count,
+                                         size_t capacity) {
+    for (size_t i = 0; i < count; ++i) {
+        if (self->allocator) {
+            columns[i] = self->allocator->alloc(
+                self->allocator->ctx, capacity * sizes[i], aligns[i]);
+        } else {
+            columns[i] = libv_default_alloc(capacity * sizes[i], aligns[i]);
+        }
+        if (!columns[i]) {
+            vsoa_raw self_ = *self;
+            self_.capacity = capacity;
+            while (i--) {
+                vsoa_raw_free_column(&self_, columns[i], sizes[i], aligns[i]);
+            }
+            return LIBV_ERR;
+        }
+    }
+    return LIBV_OK;
+}
+
+// copies the elements of column into the freshly allocated to and frees
+// column
+static inline void vsoa_raw_move_column(const vsoa_raw* self, void* to,
+                                        void* column, size_t size,
+                                        size_t align) {
+    if (self->size) {
+        memcpy(to, column, self->size * size);
+    }
+    vsoa_raw_free_column(self, column, size, align);
+}
+
+#define VSOA_COLUMN_ALIGN_(type_)                                              \
+    (_Alignof(type_) > LIBV_CACHE_LINE_SIZE ? _Alignof(type_)                  \
+                                            : LIBV_CACHE_LINE_SIZE)
+
+// callbacks handed to the field list, self and index are in scope where they
+// are expanded
+#define VSOA_MEMBER_(type_, field_) type_ field_;
+#define VSOA_COLUMN_(type_, field_) type_* field_;
+#define VSOA_PARAM_(type_, field_) , type_ field_
+#define VSOA_NULL_(type_, field_) NULL,
+#define VSOA_SIZE_(type_, field_) sizeof(type_),
+#define VSOA_ALIGN_(type_, field_) VSOA_COLUMN_ALIGN_(type_),
+#define VSOA_MOVE_(type_, field_)                                              \
+    vsoa_raw_move_column(&self->soa, columns[index], self->field_,             \
+                         sizeof(type_), VSOA_COLUMN_ALIGN_(type_));            \
+    self->field_ = (type_*)columns[index++];
+#define VSOA_FREE_(type_, field_)                                              \
+    vsoa_raw_free_column(&self->soa, self->field_, sizeof(type_),              \
+                         VSOA_COLUMN_ALIGN_(type_));                           \
+    self->field_ = NULL;
+#define VSOA_STORE_(type_, field_) self->field_[index] = field_;
+#define VSOA_STORE_ROW_(type_, field_) self->field_[index] = row->field_;
+#define VSOA_LOAD_ROW_(type_, field_) out->field_ = self->field_[index];
+
+// fields_ is an x macro listing the element type, it takes a callback and
+// calls it as X(type, field) once per field:
+//
+//     #define POINT_FIELDS(X) X(float, x) X(float, y)
+//     VSOA_DECLARE(points, POINT_FIELDS);
+//
+// name_ then has a column pointer per field, points.x and points.y, and a
+// points_row struct with the same fields. no field may be named soa.
+#define VSOA_DECLARE(name_, fields_)                                           \
+    LIBV_BEGIN                                                                 \
+    typedef struct {                                                           \
+        fields_(VSOA_MEMBER_)                                                  \
+    } name_##_row;                                                             \
+    typedef struct {                                                           \
+        vsoa_raw soa;                                                          \
+        fields_(VSOA_COLUMN_)                                                  \
+    } name_;                                                                   \
+    static inline name_ name_##_new(void) { return (name_){vsoa_raw_new()}; }  \
+    static inline name_ name_##_new_in(const libv_allocator* allocator) {      \
+        return (name_){vsoa_raw_new_in(allocator)};                            \
+    }                                                                          \
+    static inline void name_##_free(name_* self) {                             \
+        fields_(VSOA_FREE_)                                                    \
+        self->soa.size = 0;                                                    \
+        self->soa.capacity = 0;                                                \
+    }                                                                          \
+    static inline bool name_##_empty(const name_* self) {                      \
+        return vsoa_raw_empty(&self->soa);                                     \
+    }                                                                          \
+    static inline size_t name_##_size(const name_* self) {                     \
+        return vsoa_raw_size(&self->soa);                                      \
+    }                                                                          \
+    static inline size_t name_##_capacity(const name_* self) {                 \
+        return vsoa_raw_capacity(&self->soa);                                  \
+    }                                                                          \
+    static inline void name_##_clear(name_* self) { self->soa.size = 0; }      \
+    static inline int name_##_reserve(name_* self, size_t new_capacity) {      \
+        if (new_capacity <= self->soa.capacity) {                              \
+            return LIBV_OK;                                                    \
+        }                                                                      \
+        void* columns[] = {fields_(VSOA_NULL_)};                               \
+        const size_t sizes[] = {fields_(VSOA_SIZE_)};                          \
+        const size_t aligns[] = {fields_(VSOA_ALIGN_)};                        \
+        if (vsoa_raw_alloc_columns(&self->soa, columns, sizes, aligns,         \
+                                   array_size(columns),                        \
+                                   new_capacity) == LIBV_ERR) {                \
+            return LIBV_ERR;                                                   \
+        }                                                                      \
+        size_t index = 0;                                                      \
+        fields_(VSOA_MOVE_)                                                    \
+        self->soa.capacity = new_capacity;                                     \
+        return LIBV_OK;                                                        \
+    }                                                                          \
+    static inline int name_##_grow(name_* self) {                              \
+        if (LIBV_LIKELY(self->soa.size < self->soa.capacity)) {                \
+            return LIBV_OK;                                                    \
+        }                                                                      \
+        return name_##_reserve(self, vsoa_raw_next_capacity(&self->soa));      \
+    }                                                                          \
+    /* takes one argument per field, in the order of fields_ */                \
+    static inline int name_##_push_back(name_* self fields_(VSOA_PARAM_)) {    \
+        if (name_##_grow(self) == LIBV_ERR) {                                  \
+            return LIBV_ERR;                                                   \
+        }                                                                      \
+        size_t index = self->soa.size++;                                       \
+        fields_(VSOA_STORE_)                                                   \
+        return LIBV_OK;                                                        \
+    }                                                                          \
+    static inline int name_##_push_row(name_* self, const name_##_row* row) {  \
+        if (name_##_grow(self) == LIBV_ERR) {                                  \
+            return LIBV_ERR;                                                   \
+        }                                                                      \
+        size_t index = self->soa.size++;                                       \
+        fields_(VSOA_STORE_ROW_)                                               \
+        return LIBV_OK;                                                        \
+    }                                                                          \
+    static inline int name_##_get_row(const name_* self, size_t index,         \
+                                      name_##_row* out) {                      \
+        if (index >= self->soa.size) {                                         \
+            return LIBV_ERR;                                                   \
+        }                                                                      \
+        fields_(VSOA_LOAD_ROW_)                                                \
+        return LIBV_OK;                                                        \
+    }                                                                          \
+    static inline int name_##_set_row(name_* self, size_t index,               \
+                                      const name_##_row* row) {                \
+        if (index >= self->soa.size) {                                         \
+            return LIBV_ERR;                                                   \
+        }                                                                      \
+        fields_(VSOA_STORE_ROW_)                                               \
+        return LIBV_OK;                                                        \
+    }                                                                          \
+    /* removes the element at index by moving the last one into its place */   \
+    static inline int name_##_swap_remove(name_* self, size_t index) {         \
+        if (index >= self->soa.size) {                                         \
+            return LIBV_ERR;                                                   \
+        }                                                                      \
+        name_##_row last;                                                      \
+        name_##_get_row(self, self->soa.size - 1, &last);                      \
+        name_##_set_row(self, index, &last);                                   \
+        self->soa.size--;                                                      \
+        return LIBV_OK;                                                        \
+    }                                                                          \
+    LIBV_END                                                                   \
+    /* Force a semicolon. */ struct name_##_needstrailingsemicolon_ { int x; }
+
+LIBV_END
+
+#endif // __LIBV_VSOA_H__
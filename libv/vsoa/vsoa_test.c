@@ -0,0 +1,135 @@
+#include "libv/vtest/vtest.h"
+#include "vsoa.h"
+#include <stdint.h>
+
+#define TRADE_FIELDS(X)                                                        \
+    X(uint64_t, id)                                                            \
+    X(double, price)                                                           \
+    X(uint32_t, quantity)                                                      \
+    X(char, side)
+
+VSOA_DECLARE(trades, TRADE_FIELDS);
+
+TEST(vsoa, push_back) {
+    trades t = trades_new();
+    assert_true(trades_empty(&t));
+
+    for (int i = 0; i < 1000; ++i) {
+        assert_int_eq(
+            trades_push_back(&t, i, i * 0.5, i * 2, i % 2 ? 'b' : 's'),
+            LIBV_OK);
+    }
+    assert_uint_eq(trades_size(&t), 1000);
+    assert_true(trades_capacity(&t) >= 1000);
+    assert_uint_eq((uintptr_t)t.id % LIBV_CACHE_LINE_SIZE, 0);
+    assert_uint_eq((uintptr_t)t.price % LIBV_CACHE_LINE_SIZE, 0);
+    assert_uint_eq((uintptr_t)t.quantity % LIBV_CACHE_LINE_SIZE, 0);
+    assert_uint_eq((uintptr_t)t.side % LIBV_CACHE_LINE_SIZE, 0);
+
+    uint64_t quantity = 0;
+    for (size_t i = 0; i < trades_size(&t); ++i) {
+        assert_uint_eq(t.id[i], i);
+        quantity += t.quantity[i];
+    }
+    assert_uint_eq(quantity, 999 * 1000);
+    assert_true(t.price[999] == 499.5);
+    assert_int_eq(t.side[998], 's');
+
+    trades_clear(&t);
+    assert_true(trades_empty(&t));
+    trades_free(&t);
+    assert_true(t.id == NULL);
+    assert_uint_eq(trades_capacity(&t), 0);
+}
+
+TEST(vsoa, rows) {
+    trades t = trades_new();
+    trades_row row = {7, 1.25, 3, 'b'};
+    assert_int_eq(trades_get_row(&t, 0, &row), LIBV_ERR);
+
+    for (int i = 0; i < 10; ++i) {
+        row.id = i;
+        assert_int_eq(trades_push_row(&t, &row), LIBV_OK);
+    }
+    assert_int_eq(trades_get_row(&t, 4, &row), LIBV_OK);
+    assert_uint_eq(row.id, 4);
+    assert_uint_eq(row.quantity, 3);
+    assert_int_eq(row.side, 'b');
+
+    row.price = 2.5;
+    assert_int_eq(trades_set_row(&t, 4, &row), LIBV_OK);
+    assert_true(t.price[4] == 2.5);
+    assert_int_eq(trades_set_row(&t, 10, &row), LIBV_ERR);
+
+    assert_int_eq(trades_swap_remove(&t, 4), LIBV_OK);
+    assert_uint_eq(trades_size(&t), 9);
+    assert_uint_eq(t.id[4], 9);
+    assert_true(t.price[4] == 1.25);
+    assert_int_eq(trades_swap_remove(&t, 8), LIBV_OK);
+    assert_uint_eq(t.id[7], 7);
+    assert_int_eq(trades_swap_remove(&t, 8), LIBV_ERR);
+
+    trades_free(&t);
+}
+
+typedef struct {
+    size_t allocs;
+    size_t frees;
+    size_t fail_after;
+} counting_ctx;
+
+static void* counting_alloc(void* ctx, size_t size, size_t align) {
+    counting_ctx* c = ctx;
+    if (c->allocs++ >= c->fail_after) {
+        return NULL;
+    }
+    return libv_default_alloc(size, align);
+}
+
+static void* counting_realloc(void* ctx, void* ptr, size_t old_size,
+                              size_t new_size, size_t align) {
+    (void)ctx;
+    return libv_default_realloc(ptr, old_size, new_size, align);
+}
+
+static void counting_free(void* ctx, void* ptr, size_t size, size_t align) {
+    if (ptr) {
+        ((counting_ctx*)ctx)->frees++;
+    }
+    libv_default_free(ptr, size, align);
+}
+
+TEST(vsoa, allocator) {
+    counting_ctx ctx = {0, 0, SIZE_MAX};
+    libv_allocator allocator = {
+        &ctx,
+        counting_alloc,
+        counting_realloc,
+        counting_free,
+    };
+
+    trades t = trades_new_in(&allocator);
+    assert_int_eq(trades_reserve(&t, 100), LIBV_OK);
+    assert_uint_eq(ctx.allocs, 4);
+    for (int i = 0; i < 100; ++i) {
+        assert_int_eq(trades_push_back(&t, i, i, i, 'b'), LIBV_OK);
+    }
+    assert_uint_eq(ctx.allocs, 4);
+
+    // the third column fails, the first two are given back and the old
+    // columns stay as they were
+    ctx.fail_after = ctx.allocs + 2;
+    assert_int_eq(trades_reserve(&t, 1000), LIBV_ERR);
+    assert_uint_eq(ctx.frees, 2);
+    assert_uint_eq(trades_capacity(&t), 100);
+    assert_uint_eq(t.id[99], 99);
+
+    ctx.fail_after = SIZE_MAX;
+    assert_int_eq(trades_reserve(&t, 1000), LIBV_OK);
+    assert_uint_eq(ctx.frees, 6);
+    assert_uint_eq(t.quantity[99], 99);
+    trades_free(&t);
+    assert_uint_eq(ctx.frees, 10);
+}
+
+VTEST_MAIN()
@@ -42,8 +42,43 @@ LIBV_BEGIN
 
 typedef struct {
     const libv_alloc_policy* alloc;
+    // when set, used instead of alloc. a vstr has no room to carry its own
+    // allocator, so strings that live in an arena use a policy built with
+    // vstr_policy_in.
+    const libv_allocator* allocator;
 } vstr_policy;
 
+static inline vstr_policy vstr_policy_in(const libv_allocator* allocator) {
+    return (vstr_policy){.alloc = NULL, .allocator = allocator};
+}
+
+static inline void* vstr_policy_alloc(const vstr_policy* policy, size_t size,
+                                      size_t align) {
+    if (policy->allocator) {
+        return policy->allocator->alloc(policy->allocator->ctx, size, align);
+    }
+    return policy->alloc->alloc(size, align);
+}
+
+static inline void* vstr_policy_realloc(const vstr_policy* policy, void* ptr,
+                                        size_t old_size, size_t new_size,
+                                        size_t align) {
+    if (policy->allocator) {
+        return policy->allocator->realloc(policy->allocator->ctx, ptr,
+                                          old_size, new_size, align);
+    }
+    return policy->alloc->realloc(ptr, old_size, new_size, align);
+}
+
+static inline void vstr_policy_free(const vstr_policy* policy, void* ptr,
+                                    size_t size, size_t align) {
+    if (policy->allocator) {
+        policy->allocator->free(policy->allocator->ctx, ptr, size, align);
+        return;
+    }
+    policy->alloc->free(ptr, size, align);
+}
+
 typedef struct __attribute__((packed)) {
     char* data;
     uint64_t capacity;
@@ -80,7 +115,7 @@ static inline vstr_large vstr_large_from_length(const vstr_policy* policy,
                                                 const char* buf,
                                                 uint64_t buf_size) {
     vstr_large self = {0};
-    self.data = policy->alloc->alloc(buf_size + 1, _Alignof(char));
+    self.data = vstr_policy_alloc(policy, buf_size + 1, _Alignof(char));
     memcpy(self.data, buf, buf_size);
     self.data[buf_size] = '\0';
     self.capacity = buf_size + 1;
@@ -107,8 +142,8 @@ static inline vstr vstr_from(const vstr_policy* policy, const char* buf) {
 
 static inline void vstr_free(const vstr_policy* policy, vstr* self) {
     if (self->is_large) {
-        policy->alloc->free(self->string.large.data,
-                            self->string.large.capacity, _Alignof(char));
+        vstr_policy_free(policy, self->string.large.data,
+                         self->string.large.capacity, _Alignof(char));
     }
     memset(self, 0, sizeof *self);
     self->small_available = VSTR_SMALL_MAX_SIZE;
@@ -174,8 +209,8 @@ static inline int vstr_large_push_char(const vstr_policy* policy,
                                        vstr_large* self, char ch) {
     if (self->length >= self->capacity - 1) {
         uint64_t new_capacity = self->capacity << 1;
-        void* tmp = policy->alloc->realloc(self->data, self->capacity,
-                                           new_capacity, _Alignof(char));
+        void* tmp = vstr_policy_realloc(policy, self->data, self->capacity,
+                                        new_capacity, _Alignof(char));
         if (!tmp) {
             return LIBV_ERR;
         }
@@ -192,7 +227,7 @@ static inline int vstr_make_large(const vstr_policy* policy, vstr* self,
     vstr_large large = {0};
     large.capacity =
         (VSTR_SMALL_MAX_SIZE - self->small_available) + length_to_add + 1;
-    large.data = policy->alloc->alloc(large.capacity, _Alignof(char));
+    large.data = vstr_policy_alloc(policy, large.capacity, _Alignof(char));
     if (!large.data) {
         return LIBV_ERR;
     }
@@ -227,8 +262,8 @@ static inline int vstr_large_make_available(const vstr_policy* policy,
         return LIBV_OK;
     }
     uint64_t new_capacity = self->length + size + 1;
-    void* tmp = policy->alloc->realloc(self->data, self->capacity, new_capacity,
-                                       _Alignof(char));
+    void* tmp = vstr_policy_realloc(policy, self->data, self->capacity,
+                                    new_capacity, _Alignof(char));
     if (tmp == NULL) {
         return LIBV_OK;
     }
@@ -286,8 +321,8 @@ static inline int vstr_cat_vstr(const vstr_policy* policy, vstr* self,
 
 static inline void vstr_clear(const vstr_policy* policy, vstr* self) {
     if (self->is_large) {
-        policy->alloc->free(self->string.large.data,
-                            self->string.large.capacity, _Alignof(char));
+        vstr_policy_free(policy, self->string.large.data,
+                         self->string.large.capacity, _Alignof(char));
     }
     self->small_available = VSTR_SMALL_MAX_SIZE;
     self->is_large = 0;
@@ -347,8 +382,8 @@ static inline int vstr_array_realloc(const vstr_policy* policy,
         new_capacity = self->capacity << 1;
     }
     void* tmp =
-        policy->alloc->realloc(self->data, self->capacity * sizeof(vstr),
-                               new_capacity * sizeof(vstr), _Alignof(vstr));
+        vstr_policy_realloc(policy, self->data, self->capacity * sizeof(vstr),
+                            new_capacity * sizeof(vstr), _Alignof(vstr));
     if (!tmp) {
         return LIBV_ERR;
     }
@@ -414,7 +449,8 @@ static inline vstr_array vstr_split_char(const vstr_policy* policy,
     }
     return res;
 err:
-    policy->alloc->free(res.data, res.capacity * sizeof(vstr), _Alignof(vstr));
+    vstr_policy_free(policy, res.data, res.capacity * sizeof(vstr),
+                     _Alignof(vstr));
     memset(&res, 0, sizeof res);
     return res;
 }
@@ -424,8 +460,8 @@ static inline void vstr_array_free(const vstr_policy* policy,
     for (size_t i = 0; i < self->size; ++i) {
         vstr_free(policy, &self->data[i]);
     }
-    policy->alloc->free(self->data, self->capacity * sizeof(vstr),
-                        _Alignof(vstr));
+    vstr_policy_free(policy, self->data, self->capacity * sizeof(vstr),
+                     _Alignof(vstr));
 }
 
 #define VSTR_DECLARE_DEFAULT(name_)                                            \
@@ -437,6 +473,7 @@ static inline void vstr_array_free(const vstr_policy* policy,
     };                                                                         \
     const vstr_policy name_##_policy = {                                       \
         .alloc = &name_##_alloc_policy,                                        \
+        .allocator = NULL,                                                     \
     };                                                                         \
     VSTR_DECLARE(name_, name_##_policy)
 